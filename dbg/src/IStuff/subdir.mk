@@ -6,6 +6,15 @@ CPP_SRCS += \
 						../src/IStuff/recognizer.cpp \
 						../src/IStuff/tracker.cpp \
 						../src/IStuff/fakable_queue.cpp \
+						../src/IStuff/feature_backend.cpp \
+						../src/IStuff/persistent_matcher.cpp \
+						../src/IStuff/vocabulary.cpp \
+						../src/IStuff/frame_pool.cpp \
+						../src/IStuff/worker.cpp \
+						../src/IStuff/recognition_pool.cpp \
+						../src/IStuff/point_index.cpp \
+						../src/IStuff/recognition_scheduler.cpp \
+						../src/IStuff/feature_table.cpp \
 
 OBJS += \
 				./src/IStuff/object.o \
@@ -14,6 +23,15 @@ OBJS += \
 				./src/IStuff/recognizer.o \
 				./src/IStuff/tracker.o \
 				./src/IStuff/fakable_queue.o \
+				./src/IStuff/feature_backend.o \
+				./src/IStuff/persistent_matcher.o \
+				./src/IStuff/vocabulary.o \
+				./src/IStuff/frame_pool.o \
+				./src/IStuff/worker.o \
+				./src/IStuff/recognition_pool.o \
+				./src/IStuff/point_index.o \
+				./src/IStuff/recognition_scheduler.o \
+				./src/IStuff/feature_table.o \
 
 CPP_DEPS += \
 						./src/IStuff/object.d \
@@ -22,6 +40,15 @@ CPP_DEPS += \
 						./src/IStuff/recognizer.d \
 						./src/IStuff/tracker.d \
 						./src/IStuff/fakable_queue.d \
+						./src/IStuff/feature_backend.d \
+						./src/IStuff/persistent_matcher.d \
+						./src/IStuff/vocabulary.d \
+						./src/IStuff/frame_pool.d \
+						./src/IStuff/worker.d \
+						./src/IStuff/recognition_pool.d \
+						./src/IStuff/point_index.d \
+						./src/IStuff/recognition_scheduler.d \
+						./src/IStuff/feature_table.d \
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -1,12 +1,24 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 						../src/main.cpp \
+						../src/benchmark.cpp \
+						../src/pipeline.cpp \
+						../src/video_output.cpp \
+						../src/result_writer.cpp \
 
 OBJS += \
 				./src/main.o \
+				./src/benchmark.o \
+				./src/pipeline.o \
+				./src/video_output.o \
+				./src/result_writer.o \
 
 CPP_DEPS += \
 						./src/main.d \
+						./src/benchmark.d \
+						./src/pipeline.d \
+						./src/video_output.d \
+						./src/result_writer.d \
 
 # Each subdirectory must supply rules for building sources it contributes
 src/%.o: ../src/%.cpp
@@ -0,0 +1,212 @@
+/**
+ * @file bounded_queue.h
+ * @brief Header file for IStuff::BoundedQueue.
+ * @details Being a template, the class is defined here too.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef I_STUFF_BOUNDED_QUEUE_H__
+#define I_STUFF_BOUNDED_QUEUE_H__
+
+#include <deque>
+#include <algorithm>
+
+#include <boost/thread.hpp>
+
+namespace IStuff
+{
+  /**
+   * @brief A synchronized FIFO queue holding at most a fixed number of elements.
+   * @details Producers either wait for room or give up, consumers wait for an
+   *  element. Once closed the queue accepts no more elements, but the ones
+   *  left can still be taken; then waiting consumers are woken up.
+   */
+  template <typename T>
+  class BoundedQueue
+  {
+    /* Attributes */
+    private:
+      std::deque<T> m_items;
+      size_t m_capacity;
+      bool m_closed;
+      size_t m_dropped;
+
+      mutable boost::mutex m_mutex;
+      boost::condition_variable m_not_empty,
+                                m_not_full;
+
+      /* Methods */
+    public:
+      /* Constructors and Destructors */
+
+      /**
+       * @brief Constructs an empty queue.
+       *
+       * @param[in] capacity  The maximum number of elements, at least 1.
+       */
+      BoundedQueue(size_t capacity)
+        : m_capacity(std::max(capacity, (size_t) 1)), m_closed(false),
+          m_dropped(0)
+      {}
+
+      virtual ~BoundedQueue()
+      {}
+
+      /* Setters */
+
+      /**
+       * @brief Adds an element, waiting for room if the queue is full.
+       *
+       * @return `false` if the queue is closed.
+       */
+      bool push(const T& item)
+      {
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+
+        while (!m_closed && m_items.size() >= m_capacity)
+          m_not_full.wait(lock);
+
+        if (m_closed)
+          return false;
+
+        m_items.push_back(item);
+        m_not_empty.notify_one();
+
+        return true;
+      }
+
+      /**
+       * @brief Adds an element if there is room for it.
+       *
+       * @return `false` if the queue is full or closed.
+       */
+      bool tryPush(const T& item)
+      {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+
+        if (m_closed || m_items.size() >= m_capacity)
+          return false;
+
+        m_items.push_back(item);
+        m_not_empty.notify_one();
+
+        return true;
+      }
+
+      /**
+       * @brief Adds an element, dropping the oldest one if the queue is full.
+       * @details The producer never waits: the latest element always wins.
+       *
+       * @return `false` if the queue is closed.
+       */
+      bool pushLatest(const T& item)
+      {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+
+        if (m_closed)
+          return false;
+
+        if (m_items.size() >= m_capacity)
+        {
+          m_items.pop_front();
+          m_dropped++;
+        }
+
+        m_items.push_back(item);
+        m_not_empty.notify_one();
+
+        return true;
+      }
+
+      /**
+       * @brief Takes the oldest element, waiting for one if the queue is empty.
+       *
+       * @param[out] item  The element taken.
+       *
+       * @return `false` if the queue is closed and empty.
+       */
+      bool pop(T& item)
+      {
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+
+        while (!m_closed && m_items.empty())
+          m_not_empty.wait(lock);
+
+        if (m_items.empty())
+          return false;
+
+        item = m_items.front();
+        m_items.pop_front();
+        m_not_full.notify_one();
+
+        return true;
+      }
+
+      /**
+       * @brief Takes the oldest element, if there is one.
+       *
+       * @param[out] item  The element taken.
+       *
+       * @return `false` if the queue is empty.
+       */
+      bool tryPop(T& item)
+      {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+
+        if (m_items.empty())
+          return false;
+
+        item = m_items.front();
+        m_items.pop_front();
+        m_not_full.notify_one();
+
+        return true;
+      }
+
+      /**
+       * @brief Closes the queue, waking up every thread waiting on it.
+       */
+      void close()
+      {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+
+        m_closed = true;
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+      }
+
+      /* Getters */
+
+      bool isClosed() const
+      {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+
+        return m_closed;
+      }
+
+      size_t size() const
+      {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+
+        return m_items.size();
+      }
+
+      size_t capacity() const
+      {
+        return m_capacity;
+      }
+
+      /**
+       * @brief Returns how many elements were dropped by pushLatest().
+       */
+      size_t getDropped() const
+      {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+
+        return m_dropped;
+      }
+  };
+}
+
+#endif /* defined I_STUFF_BOUNDED_QUEUE_H__ */
@@ -15,6 +15,15 @@ using namespace IStuff;
 
 namespace fs = boost::filesystem;
 
+typedef boost::chrono::high_resolution_clock Clock;
+
+/**
+ * @brief	Seconds elapsed between two instants
+ */
+static double elapsed( Clock::time_point from, Clock::time_point to ) {
+	return boost::chrono::duration< double >( to - from ).count();
+}
+
 /**
  * @brief	Constructor
  * @details	If the name passed matches an existing DB it loads it,
@@ -22,12 +31,14 @@ namespace fs = boost::filesystem;
  * @param[in] _dbName The name of the DB to be loaded
  * @param[in] imagesPath The position of the sample images from which
  * 			the descriptors are to be taken
+ * @param[in] _backend The features and matcher used to create the DB.
+ * 			An existing DB is always loaded with the backend it was created with
+ * @param[in] _buildThreads The number of threads used to create the DB,
+ * 			0 for one per core
  */
-Database::Database( string _dbName, string imagesPath ) :
-	dbPath( "database/" ), dbName( _dbName )
+Database::Database( string _dbName, string imagesPath, FeatureBackend _backend, int _buildThreads ) :
+	dbPath( "database/" ), dbName( _dbName ), backend( _backend ), recognitionScale( 1 ), candidateCount( 10 ), hypothesisCount( 3 ), contextCount( 0 ), buildThreads( _buildThreads )
 {
-	initModule_nonfree();
-
 	// Check for database existence
 	string dbFileName = dbPath + dbName + ".sbra";
 	ifstream file_check( dbFileName.c_str(), ios::binary );
@@ -41,12 +52,18 @@ Database::Database( string _dbName, string imagesPath ) :
 		} catch( DBCreationException& e ) {
 			throw e;
 		}
+
+		// A vocabulary left by a former database with the same name doesn't describe this one
+		fs::remove( dbPath + dbName + ".bow" );
 	} else {
 		if( debug )
 			cerr << "Opening DB " << _dbName << endl;
 
 		load();
 	}
+
+	if( vocabulary.load( dbPath + dbName + ".bow", nameDB ) && debug )
+		cerr << "\tVocabulary of " << vocabulary.size() << " words loaded\n";
 }
 
 /**
@@ -56,142 +73,816 @@ Database::~Database() {
 
 }
 
+/**
+ * @brief	Builds the feature pipeline and the matcher of the backend
+ * @details	The pipeline is used by build(), every MatchContext creates its own
+ */
+void Database::createPipeline() {
+	Clock::time_point start = Clock::now();
+
+	features = backend.createFeatures();
+	matcher = backend.createMatcher();
+
+	profile.construction = elapsed( start, Clock::now() );
+
+	if( debug )
+		cerr << "\tUsing " << backend.getFeaturesName() << " features with " << backend.getMatcherName() << " matcher\n";
+}
+
+/**
+ * @brief	Fills the matcher with the descriptors and trains it
+ * @details	See the other overload
+ */
+void Database::trainMatcher() {
+	trainMatcher( matcher, descriptorDB, indexFileName );
+}
+
+/**
+ * @brief	Fills a matcher with descriptors and trains it
+ * @details	A persistent matcher reads the index of the descriptors from its
+ * 			file if there is one; otherwise it's trained and the index is
+ * 			written for the next start, replacing the ones of the previous
+ * 			versions of the database. Nothing of the Database is changed, so a
+ * 			new matcher can be trained while the current one is matching
+ * @param[in,out] target	The matcher, of the backend of the Database
+ * @param[in] descriptors	The descriptors of every sample
+ * @param[out] targetIndexFile	The file of the trained index, unchanged if the matcher isn't persistent
+ */
+void Database::trainMatcher( Ptr< DescriptorMatcher >& target, const vector< Mat >& descriptors, string& targetIndexFile ) const {
+	target -> clear();
+	target -> add( descriptors );
+
+	PersistentFlannMatcher* flannMatcher = dynamic_cast< PersistentFlannMatcher* >( target.obj );
+
+	if( !backend.isPersistent() || !flannMatcher ) {
+		target -> train();
+		return;
+	}
+
+	targetIndexFile = dbPath + dbName + "." + indexChecksum( descriptors ) + ".flann";
+
+	if( flannMatcher -> loadIndex( targetIndexFile ) ) {
+		if( debug )
+			cerr << "\tIndex loaded from " << targetIndexFile << endl;
+
+		return;
+	}
+
+	target -> train();
+
+	// Remove the stale indexes, they would never match again. Only <dbName>.<8 hex digits>.flann
+	// files are ours: another database may be called <dbName>.<something>
+	fs::path indexPath( targetIndexFile );
+	string prefix = dbName + ".", suffix = ".flann";
+	size_t checksumLength = 8;
+
+	for( fs::directory_iterator it( indexPath.parent_path() ); it != fs::directory_iterator(); ++it ) {
+		string fileName = it -> path().filename().string();
+
+		if( fileName.size() != prefix.size() + checksumLength + suffix.size() || fileName.compare( 0, prefix.size(), prefix )
+				|| fileName.compare( prefix.size() + checksumLength, suffix.size(), suffix ) || it -> path() == indexPath )
+			continue;
+
+		string checksum = fileName.substr( prefix.size(), checksumLength );
+
+		if( count_if( checksum.begin(), checksum.end(), ::isxdigit ) == (int) checksumLength )
+			fs::remove( it -> path() );
+	}
+
+	if( flannMatcher -> saveIndex( targetIndexFile ) && debug )
+		cerr << "\tIndex saved to " << targetIndexFile << endl;
+}
+
+/**
+ * @brief	Checksum of the data the trained index depends on
+ * @details	That is the backend, the number of trees and every descriptor
+ * @param[in] descriptors	The descriptors of every sample
+ * @retval	The CRC-32 of the data, as an hexadecimal string
+ */
+string Database::indexChecksum( const vector< Mat >& descriptors ) const {
+	boost::crc_32_type crc;
+	string matcherName = backend.getFeaturesName() + "/" + backend.getMatcherName();
+	int trees = backend.getTrees();
+
+	crc.process_bytes( matcherName.data(), matcherName.size() );
+	crc.process_bytes( &trees, sizeof( trees ) );
+
+	for( vector< Mat >::const_iterator it = descriptors.begin(); it != descriptors.end(); it++ ) {
+		int geometry[] = { it -> rows, it -> cols, it -> type() };
+		crc.process_bytes( geometry, sizeof( geometry ) );
+
+		for( int r = 0; r < it -> rows; r++ )
+			crc.process_bytes( it -> ptr( r ), it -> cols * it -> elemSize() );
+	}
+
+	ostringstream checksum;
+	checksum << hex << setw( 8 ) << setfill( '0' ) << crc.checksum();
+
+	return checksum.str();
+}
+
+/**
+ * @brief	Adds the stage times of a match
+ */
+void AtomicMatchProfile::add( const MatchProfile& stages ) {
+	calls += stages.calls;
+
+	// No fetch_add for floating point atomics
+	std::atomic< double >* totals[] = { &resize, &features, &retrieval, &matching, &homography };
+	double values[] = { stages.resize, stages.features, stages.retrieval, stages.matching, stages.homography };
+
+	for( int i = 0; i < 5; i++ ) {
+		double total = totals[ i ] -> load();
+		while( !totals[ i ] -> compare_exchange_weak( total, total + values[ i ] ) );
+	}
+}
+
+/**
+ * @brief	Returns the stage times summed so far
+ */
+MatchProfile AtomicMatchProfile::load() const {
+	MatchProfile stages;
+
+	stages.calls = calls;
+	stages.construction = construction;
+	stages.resize = resize;
+	stages.features = features;
+	stages.retrieval = retrieval;
+	stages.matching = matching;
+	stages.homography = homography;
+
+	return stages;
+}
+
 /**
  * @brief	Search for descriptors matching in passed frame
  * @details	Given an image, searches for descriptor matches in the database
- *			and returns an object containing the estimated label positions
+ *			and returns an object containing the estimated label positions.
+ * 			Of the samples verified by matchAll() the one with the most
+ * 			inliers is returned
  * @param[in] frame	The image to search into
  * @retval	An Object containing an association between the labels and the
  * 			positions in which every label is found
  * */
-Object Database::match( Mat scene ) {
+Object Database::match( Mat scene ) const {
+	vector< Object > objects = matchAll( scene, 1 );
+
+	return objects.empty() ? Object() : objects[ 0 ];
+}
+
+/**
+ * @brief	Search for every sample visible in the passed frame
+ * @details	Uses a MatchContext of the calling thread, so that threads can
+ * 			match at the same time, each reusing its own buffers
+ * @param[in] scene	The image to search into
+ * @param[in] maxObjects	The maximum number of objects returned
+ * @retval	The objects found, the one with the most inliers first
+ */
+vector< Object > Database::matchAll( Mat scene, size_t maxObjects ) const {
+	static thread_local MatchContext context;
+
+	return matchAll( context, scene, maxObjects );
+}
+
+/**
+ * @brief	Verifies a range of the hypotheses of a match
+ * @details	Used by matchAll() with cv::parallel_for_, every hypothesis
+ * 			is written by one thread only
+ */
+class Database::HypothesisVerifier : public ParallelLoopBody {
+	public:
+		HypothesisVerifier( const Database& database, MatchContext& context )
+			: database( database ), context( context )
+		{}
+
+		void operator()( const Range& range ) const {
+			for( int h = range.start; h < range.end; h++ )
+				database.verify( context, context.hypotheses[ h ] );
+		}
+
+	private:
+		const Database& database;
+		MatchContext& context;
+};
+
+/**
+ * @brief	Search for every sample visible in the passed frame
+ * @details	Every frame descriptor votes for the sample of its nearest
+ * 			neighbour, then the hypothesisCount samples with the most votes
+ * 			are verified in parallel, each one estimating its own homography.
+ * 			A sample failing the verification doesn't hide the following ones.
+ * 			The verified samples are accepted by decreasing number of inliers,
+ * 			unless their inliers lie mostly in the area of an accepted one.
+ * 			Only the context is written, and only the feature pipeline of the
+ * 			context runs; the samples and the trained matcher are shared, read
+ * 			only, with the other matches running
+ * @param[in,out] context	The buffers of the match, not used by other calls meanwhile
+ * @param[in] scene	The image to search into
+ * @param[in] maxObjects	The maximum number of objects returned
+ * @retval	The objects found, the one with the most inliers first
+ */
+vector< Object > Database::matchAll( MatchContext& context, Mat scene, size_t maxObjects ) const {
 	if( debug )
 		cerr << "Start matching\n";
 
-	Object matchingObject;
+	boost::shared_lock< boost::shared_mutex > lock( samplesMutex );
 
-	// Calculate SIFT keypoints and descriptors
-	Ptr< FeatureDetector > featureDetector = FeatureDetector::create( "SIFT" );
-	Ptr< DescriptorExtractor > featureExtractor = DescriptorExtractor::create( "SIFT" );
+	// A context gets its own candidate matcher and feature pipeline from the first Database
+	// it's used with: concurrent matches share no Feature2D
+	if( context.owner != this ) {
+		context.owner = this;
+		context.id = contextCount++;
+		context.candidateMatcher = backend.createBruteForceMatcher();
+		context.features = backend.createFeatures();
+	}
+
+	vector< Object > objects;
+	MatchProfile& stages = context.profile;
 
-	vector< KeyPoint > sceneKeypoints;
-	Mat sceneDescriptors;
+	stages = MatchProfile();
+	stages.calls = 1;
 
-	featureDetector -> detect( scene, sceneKeypoints );
-	featureExtractor -> compute( scene, sceneKeypoints, sceneDescriptors );
+	Clock::time_point stageStart = Clock::now(), stageEnd;
+
+	// Work on a downscaled copy of the frame if requested
+	if( recognitionScale < 1 ) {
+		resize( scene, context.scaledScene, Size(), recognitionScale, recognitionScale, INTER_AREA );
+		scene = context.scaledScene;
+	}
+
+	stageEnd = Clock::now();
+	stages.resize += elapsed( stageStart, stageEnd );
+	stageStart = stageEnd;
+
+	// Calculate keypoints and descriptors in a single pass, building the scale space only once
+	// and reusing the buffers of the previous call with the same context
+	( *context.features )( scene, noArray(), context.sceneKeypoints, context.sceneDescriptors );
+
+	stageEnd = Clock::now();
+	stages.features += elapsed( stageStart, stageEnd );
+	stageStart = stageEnd;
 
 	if( debug )
 		cerr << "\t\tFrame keypoints and descriptors computed\n";
 
-	// Matching..
-	vector< vector< DMatch > > matches;
-	vector< DMatch > goodMatches;
+	// Retrieval of the candidate samples, when the database is larger than their number.
+	// They are matched exhaustively, as building an index over their descriptors at every frame
+	// would cost as much as the search it saves; the image indexes are then mapped back to the samples
+	if( !vocabulary.empty() && candidateCount < descriptorDB.size() ) {
+		vocabulary.query( context.sceneDescriptors, candidateCount, context.candidates );
 
-	matcher.knnMatch( sceneDescriptors, matches, 2 );
+		context.candidateDescriptors.clear();
+		for( vector< int >::iterator it = context.candidates.begin(); it != context.candidates.end(); it++ )
+			context.candidateDescriptors.push_back( descriptorDB[ *it ] );
 
-	if( debug )
-		cerr << "\tStart searching for the best sample\n";
+		if( debug )
+			cerr << "\t" << context.candidates.size() << " candidate samples retrieved\n";
 
-	// I consider only the sample with the biggest number of matches (the index will be contained in maxSample)
-	vector< int > bestSample( labelDB.size(), 0 );
+		stageEnd = Clock::now();
+		stages.retrieval += elapsed( stageStart, stageEnd );
+		stageStart = stageEnd;
 
-	for( vector< vector< DMatch > >::iterator m = matches.begin(); m != matches.end(); m++ )
-		bestSample[ ( *m )[0].imgIdx ]++;
+		context.matches.clear();
+		context.candidateMatcher -> clear();
 
-	int maxSample = 0;
+		if( !context.candidateDescriptors.empty() ) {
+			context.candidateMatcher -> add( context.candidateDescriptors );
+			context.candidateMatcher -> knnMatch( context.sceneDescriptors, context.matches, 2 );
+		}
 
-	for( int i = 1; i < bestSample.size(); i++ )
-		if( bestSample[ i ] > bestSample[ maxSample ] )
-			maxSample = i;
+		for( vector< vector< DMatch > >::iterator m = context.matches.begin(); m != context.matches.end(); m++ )
+			for( vector< DMatch >::iterator it = m -> begin(); it != m -> end(); it++ )
+				it -> imgIdx = context.candidates[ it -> imgIdx ];
+	} else
+		matcher -> knnMatch( context.sceneDescriptors, context.matches, 2 );
 
 	if( debug )
-		cerr << "\tBest sample is #" << maxSample << endl;
+		cerr << "\tStart searching for the best samples\n";
 
-	// Keep only the matches with a significant difference in distance between the two nearest neighbours and regarding the best sample
+	// Every frame descriptor votes for the sample of its nearest neighbour
+	context.votes.assign( labelDB.size(), 0 );
+
+	// NOTE approximate matchers (LSH) may return less than two neighbours for a descriptor
+	for( vector< vector< DMatch > >::iterator m = context.matches.begin(); m != context.matches.end(); m++ )
+		if( !m -> empty() )
+			context.votes[ ( *m )[0].imgIdx ]++;
+
+	// Keep only the matches with a significant difference in distance between the two nearest neighbours
 	if( debug )
-		cerr << "\t\t" << matches.size() << " matches found, start filtering the good ones\n";
+		cerr << "\t\t" << context.matches.size() << " matches found, start filtering the good ones\n";
+
+	context.goodMatches.clear();
+
+	for( int i = 0; i < context.matches.size(); i++ )
+		if( context.matches[ i ].size() == 2 && context.matches[ i ][ 0 ].distance <= NNDR_RATIO * context.matches[ i ][ 1 ].distance )
+			context.goodMatches.push_back( context.matches[ i ][ 0 ] );
+
+	// The samples with the most votes are the hypotheses to be verified.
+	// A sample with less than MATCH_THRESHOLD votes can't have enough good matches
+	context.ranking.clear();
+
+	for( int i = 0; i < context.votes.size(); i++ )
+		if( context.votes[ i ] >= MATCH_THRESHOLD )
+			context.ranking.push_back( make_pair( context.votes[ i ], i ) );
 
-	for( int i = 0; i < matches.size(); i++ )
-		if( matches[ i ][ 0 ].imgIdx == maxSample && matches[ i ][ 0 ].distance <= NNDR_RATIO * matches[ i ][ 1 ].distance )
-			goodMatches.push_back( matches[ i ][ 0 ] );
+	size_t verifiedCount = min( hypothesisCount, context.ranking.size() );
+	partial_sort( context.ranking.begin(), context.ranking.begin() + verifiedCount, context.ranking.end(), greater< pair< int, int > >() );
+
+	context.hypotheses.resize( verifiedCount );
+
+	for( size_t h = 0; h < verifiedCount; h++ ) {
+		context.hypotheses[ h ].sample = context.ranking[ h ].second;
+		context.hypotheses[ h ].votes = context.ranking[ h ].first;
+	}
 
 	if( debug )
-		cerr << "\t\t" << goodMatches.size() << " good matches found, starting object localization\n";
+		cerr << "\t\t" << context.goodMatches.size() << " good matches found, verifying " << verifiedCount << " samples\n";
+
+	stageEnd = Clock::now();
+	stages.matching += elapsed( stageStart, stageEnd );
+	stageStart = stageEnd;
 	
 	// Object localization
 	// Prints out the good matching keypoints and draws them for debug
 	if( debug ) {
-		for( int i = 0; i < goodMatches.size(); i++ )
+		for( int i = 0; i < context.goodMatches.size(); i++ )
 			cerr <<"\tGood match #" << i
-					<< "\n\t\tsceneDescriptorIndex: " << goodMatches[ i ].queryIdx
-					<< "\n\t\tsampleDescriptorIndex: " << goodMatches[ i ].trainIdx
-					<< "\n\t\tsampleImageIndex: " << goodMatches[ i ].imgIdx << "\n\n";
+					<< "\n\t\tsceneDescriptorIndex: " << context.goodMatches[ i ].queryIdx
+					<< "\n\t\tsampleDescriptorIndex: " << context.goodMatches[ i ].trainIdx
+					<< "\n\t\tsampleImageIndex: " << context.goodMatches[ i ].imgIdx << "\n\n";
 
 		Mat imgKeypoints;
-		drawKeypoints( scene, sceneKeypoints, imgKeypoints, Scalar::all( -1 ), DrawMatchesFlags::DEFAULT );
+		drawKeypoints( scene, context.sceneKeypoints, imgKeypoints, Scalar::all( -1 ), DrawMatchesFlags::DEFAULT );
 
-		string outsbra = "keypoints_sample/" + dbName + "Frame.jpg";
+		// Every context has its own image, so that concurrent matches don't write the same file
+		string outsbra = "keypoints_sample/" + dbName + "Frame" + boost::lexical_cast< string >( context.id ) + ".jpg";
 
 		imwrite( outsbra, imgKeypoints );
 	}
 
-	// Analyze the keypoints found for the sample to estimate homography and apply a perspectiveTransform
-	// to the labels associated to that sample
-	vector< Point2f > samplePoints, scenePoints;
+	// The hypotheses are verified on the threads of OpenCV, started once for the process.
+	// On the threads of a RecognitionPool the other streams already keep the cores busy
+	if( RecognitionPool::isPoolThread() ) {
+		for( vector< Hypothesis >::iterator it = context.hypotheses.begin(); it != context.hypotheses.end(); it++ )
+			verify( context, *it );
+	} else
+		parallel_for_( Range( 0, (int) context.hypotheses.size() ), HypothesisVerifier( *this, context ) );
 
-	for( int i = 0; i < goodMatches.size(); i++ )
-		if( goodMatches[ i ].imgIdx == maxSample ) {
-			samplePoints.push_back( keypointDB[ maxSample ][ goodMatches[ i ].trainIdx ].pt );
-			scenePoints.push_back( sceneKeypoints[ goodMatches[ i ].queryIdx ].pt );
+	// Accept the verified samples with the most inliers first, skipping the ones overlapping an accepted one
+	vector< Hypothesis* > verified, accepted;
+
+	for( vector< Hypothesis >::iterator it = context.hypotheses.begin(); it != context.hypotheses.end(); it++ )
+		if( it -> verified )
+			verified.push_back( &*it );
+
+	stable_sort( verified.begin(), verified.end(), []( const Hypothesis* a, const Hypothesis* b ) {
+		return a -> inliersCount > b -> inliersCount;
+	} );
+
+	for( vector< Hypothesis* >::iterator it = verified.begin(); it != verified.end() && objects.size() < maxObjects; it++ ) {
+		bool overlapping = false;
+
+		for( vector< Hypothesis* >::iterator other = accepted.begin(); other != accepted.end() && !overlapping; other++ )
+			overlapping = ( ( *it ) -> area & ( *other ) -> area ).area() > MAX_OVERLAP * min( ( *it ) -> area.area(), ( *other ) -> area.area() );
+
+		if( overlapping ) {
+			if( debug )
+				cerr << "\tSample #" << ( *it ) -> sample << " overlaps a better sample, skipping it\n";
+
+			continue;
 		}
 
+		if( debug )
+			cerr << "\tSample #" << ( *it ) -> sample << " found with " << ( *it ) -> inliersCount << " inliers, mapping "
+				<< labelDB[ ( *it ) -> sample ].size() << " label points\n";
+
+		accepted.push_back( *it );
+		objects.push_back( labelObject( **it ) );
+	}
+
+	stages.homography += elapsed( stageStart, Clock::now() );
+	profile.add( stages );
+
 	if( debug )
-		cerr << "\t" << samplePoints.size() << " definitely good matches found\n";
+		cerr << "\n\tMatching done. Returning " << objects.size() << " objects\n\n";
+
+	return objects;
+}
 
-	if( samplePoints.size() < MATCH_THRESHOLD ) {
+/**
+ * @brief	Verifies that a sample is in the frame
+ * @details	Estimates the homography from the good matches of the sample and
+ * 			checks its inliers. Only reads the state of the current match, so
+ * 			several hypotheses can be verified at the same time
+ * @param[in] context	The current match
+ * @param[in,out] hypothesis	The sample to be verified, receives the homography,
+ * 			the inliers and their bounding box in the frame
+ */
+void Database::verify( const MatchContext& context, Hypothesis& hypothesis ) const {
+	hypothesis.verified = false;
+	hypothesis.inliersCount = 0;
+
+	// Analyze the keypoints found for the sample to estimate homography
+	hypothesis.samplePoints.clear();
+	hypothesis.scenePoints.clear();
+
+	const vector< DMatch >& goodMatches = context.goodMatches;
+
+	for( int i = 0; i < goodMatches.size(); i++ )
+		if( goodMatches[ i ].imgIdx == hypothesis.sample ) {
+			hypothesis.samplePoints.push_back( keypointDB[ hypothesis.sample ][ goodMatches[ i ].trainIdx ].pt );
+			hypothesis.scenePoints.push_back( context.sceneKeypoints[ goodMatches[ i ].queryIdx ].pt * ( 1. / recognitionScale ) );
+		}
+
+	if( hypothesis.samplePoints.size() < MATCH_THRESHOLD ) {
 		if( debug )
-			cerr << "\tToo few keypoints, exiting..\n";
+			cerr << "\tSample #" << hypothesis.sample << ": too few keypoints (" << hypothesis.samplePoints.size() << ")\n";
 
-		return matchingObject;
+		return;
 	}
 
-	// Calculate homography mask, apply transformation to the label points and add the labels to the object 
-	// However, if the number of outliers found is too high, an error is given
-	vector< uchar > inliers;
-	
-	Mat H = findHomography( samplePoints, scenePoints, CV_RANSAC, 3, inliers );
+	// Calculate homography mask. However, if the number of outliers found is too high, the sample is rejected
+	hypothesis.homography = findHomography( hypothesis.samplePoints, hypothesis.scenePoints, CV_RANSAC, 3, hypothesis.inliers );
 
-	int inliersCount = accumulate( inliers.begin(), inliers.end(), 0 );
-	float inliersRatio = (float) inliersCount / inliers.size();
+	if( hypothesis.homography.empty() )
+		return;
 
-	if( debug )
-		cerr << "\tInliers ratio is " << inliersRatio << endl;
+	hypothesis.inliersCount = accumulate( hypothesis.inliers.begin(), hypothesis.inliers.end(), 0 );
+	float inliersRatio = (float) hypothesis.inliersCount / hypothesis.inliers.size();
 
 	if( inliersRatio < MIN_INLIER_RATIO ) {
 		if( debug )
-			cerr << "\tToo many outliers\n";
+			cerr << "\tSample #" << hypothesis.sample << ": too many outliers, inliers ratio is " << inliersRatio << endl;
 
-		return matchingObject;
+		return;
 	}
 
-	if( debug )
-		cerr << "\tHomography matrix calculated, mapping " << labelDB[ maxSample ].size() << " label points\n";
+	Point2f low( FLT_MAX, FLT_MAX ), high( -FLT_MAX, -FLT_MAX );
+
+	for( size_t i = 0; i < hypothesis.inliers.size(); i++ )
+		if( hypothesis.inliers[ i ] ) {
+			low.x = min( low.x, hypothesis.scenePoints[ i ].x );
+			low.y = min( low.y, hypothesis.scenePoints[ i ].y );
+			high.x = max( high.x, hypothesis.scenePoints[ i ].x );
+			high.y = max( high.y, hypothesis.scenePoints[ i ].y );
+		}
+
+	hypothesis.area = Rect( Point( floor( low.x ), floor( low.y ) ), Point( ceil( high.x ) + 1, ceil( high.y ) + 1 ) );
+	hypothesis.verified = true;
+}
+
+/**
+ * @brief	Maps the labels of a verified sample to the frame
+ * @param[in] hypothesis	The verified sample
+ * @retval	An Object with the labels of the sample in their frame positions
+ */
+Object Database::labelObject( const Hypothesis& hypothesis ) const {
+	Object matchingObject;
+	const vector< Label >& labels = labelDB[ hypothesis.sample ];
+
+	if( labels.empty() )
+		return matchingObject;
 
 	vector< Point2f > mappedPoints, re;
 
-	for( vector< Label >::iterator point = labelDB[ maxSample ].begin(); point != labelDB[ maxSample ].end(); point++ )
+	for( vector< Label >::const_iterator point = labels.begin(); point != labels.end(); point++ )
 		mappedPoints.push_back( ( *point ).position );
 
-	perspectiveTransform( mappedPoints, re, H );
+	perspectiveTransform( mappedPoints, re, hypothesis.homography );
 
 	for( int i = 0; i < mappedPoints.size(); i++ )
-		matchingObject.addLabel( Label( labelDB[ maxSample ][ i ].name, re[ i ], labelDB[ maxSample ][ i ].color ) );
+		matchingObject.addLabel( Label( labels[ i ].name, re[ i ], labels[ i ].color ) );
+
+	return matchingObject;
+}
+
+/**
+ * @brief	Adds a sample image to the database, or updates it
+ * @details	See updateSamples()
+ * @param[in] imagePath	The sample image, its labels are in the .lbl file with the same name
+ * @retval	false if the image can't be read
+ */
+bool Database::addSample( string imagePath ) {
+	vector< string > failed;
+
+	return updateSamples( vector< string >( 1, imagePath ), vector< string >(), failed );
+}
+
+/**
+ * @brief	Removes a sample from the database
+ * @details	See updateSamples()
+ * @param[in] name	The name of the sample, that is the stem of its image file
+ * @retval	false if there is no sample with that name
+ */
+bool Database::removeSample( string name ) {
+	vector< string > failed;
+
+	return updateSamples( vector< string >(), vector< string >( 1, name ), failed );
+}
+
+/**
+ * @brief	Adds, updates and removes several samples at once
+ * @details	Only the keypoints and descriptors of the new images are computed.
+ * 			If a sample with the same name, that is the same file name, is
+ * 			already in the database it is replaced. The removals are done
+ * 			before the additions.
+ * 			Every change is applied to a copy of the samples first, then a new
+ * 			matcher is trained on it, only once, while the matches go on with
+ * 			the current ones. The matches are held only to swap the samples and
+ * 			the matchers; the database and vocabulary files are then written
+ * 			once, without holding them
+ * @param[in] imagePaths	The sample images to be added, their labels are in the .lbl files with the same names
+ * @param[in] names	The names of the samples to be removed
+ * @param[out] failed	The images that can't be read and the names of no sample
+ * @retval	false if something failed, the other changes are applied anyway
+ */
+bool Database::updateSamples( const vector< string >& imagePaths, const vector< string >& names, vector< string >& failed ) {
+	failed.clear();
+
+	// The new samples are computed before locking, the matches go on meanwhile,
+	// with a pipeline of their own as the ones of the matches aren't shared
+	vector< SampleData > samples;
+	BuildProfile stageProfile;
+	Ptr< Feature2D > sampleFeatures = backend.createFeatures();
+
+	for( vector< string >::const_iterator it = imagePaths.begin(); it != imagePaths.end(); it++ ) {
+		SampleData sample;
+
+		if( computeSample( fs::path( *it ), sampleFeatures, sample, stageProfile ) )
+			samples.push_back( sample );
+		else
+			failed.push_back( *it );
+	}
+
+	// Only updates write the samples, so they can be read without holding the matches
+	boost::lock_guard< boost::mutex > update( updateMutex );
+
+	// Only the headers of the matrices are copied
+	vector< string > newNames = nameDB;
+	vector< vector< Label > > newLabels = labelDB;
+	vector< vector< KeyPoint > > newKeypoints = keypointDB;
+	vector< Mat > newDescriptors = descriptorDB;
+	Vocabulary newVocabulary = vocabulary;
+
+	bool changed = false;
+
+	for( vector< string >::const_iterator it = names.begin(); it != names.end(); it++ ) {
+		size_t index = find( newNames.begin(), newNames.end(), *it ) - newNames.begin();
+
+		if( index == newNames.size() ) {
+			failed.push_back( *it );
+			continue;
+		}
+
+		if( debug )
+			cerr << "Removing sample " << *it << endl;
+
+		newNames.erase( newNames.begin() + index );
+		newLabels.erase( newLabels.begin() + index );
+		newKeypoints.erase( newKeypoints.begin() + index );
+		newDescriptors.erase( newDescriptors.begin() + index );
+
+		if( !newVocabulary.empty() )
+			newVocabulary.removeSample( index );
+
+		changed = true;
+	}
+
+	// Random color generator for label coloring
+	boost::mt19937 rng( time( 0 ) );
+	boost::uniform_int<> colorRange( 0, 255 );
+	boost::variate_generator< boost::mt19937, boost::uniform_int<> > color( rng, colorRange );
+
+	for( vector< SampleData >::iterator sample = samples.begin(); sample != samples.end(); sample++ ) {
+		for( vector< Label >::iterator it = sample -> labels.begin(); it != sample -> labels.end(); it++ )
+			it -> color = Scalar( color(), color(), color() );
+
+		size_t index = find( newNames.begin(), newNames.end(), sample -> name ) - newNames.begin();
+
+		if( index < newNames.size() ) {
+			if( debug )
+				cerr << "Replacing sample " << sample -> name << endl;
+
+			newLabels[ index ] = sample -> labels;
+			newKeypoints[ index ] = sample -> keypoints;
+			newDescriptors[ index ] = sample -> descriptors;
+		} else {
+			if( debug )
+				cerr << "Adding sample " << sample -> name << endl;
+
+			newNames.push_back( sample -> name );
+			newLabels.push_back( sample -> labels );
+			newKeypoints.push_back( sample -> keypoints );
+			newDescriptors.push_back( sample -> descriptors );
+		}
+
+		if( !newVocabulary.empty() )
+			newVocabulary.setSample( index, sample -> descriptors );
+
+		changed = true;
+	}
+
+	if( !changed )
+		return failed.empty();
+
+	// A new matcher, the current one keeps matching while this one is trained
+	Ptr< DescriptorMatcher > newMatcher = backend.createMatcher();
+	string newIndexFileName = indexFileName;
+	trainMatcher( newMatcher, newDescriptors, newIndexFileName );
+
+	{
+		// The running matches end before the samples change
+		boost::unique_lock< boost::shared_mutex > lock( samplesMutex );
+
+		nameDB.swap( newNames );
+		labelDB.swap( newLabels );
+		keypointDB.swap( newKeypoints );
+		descriptorDB.swap( newDescriptors );
+		vocabulary = newVocabulary;
+		matcher = newMatcher;
+		indexFileName = newIndexFileName;
+	}
+
+	// The files are written after the swap, the matches only read the samples meanwhile
+	save();
 
+	if( !vocabulary.empty() )
+		saveVocabulary();
+
+	return failed.empty();
+}
+
+/**
+ * @brief	Sets the resolution at which frames are recognized
+ * @details	Frames are downscaled by the given factor before the keypoint
+ * 			detection, the keypoints found are then scaled back to the frame
+ * 			coordinates before estimating the homography
+ * @param[in] scale	The downscaling factor, in (0, 1]
+ */
+void Database::setRecognitionScale( float scale ) {
+	if( scale <= 0 || scale > 1 )
+		scale = 1;
+
+	boost::unique_lock< boost::shared_mutex > lock( samplesMutex );
+	recognitionScale = scale;
+}
+
+/**
+ * @brief	Returns the resolution at which frames are recognized
+ * @retval	The downscaling factor applied to the frames
+ */
+float Database::getRecognitionScale() const {
+	return recognitionScale;
+}
+
+/**
+ * @brief	Clusters the descriptors of the samples into a vocabulary of visual words
+ * @details	The vocabulary is saved next to the database and loaded with it.
+ * 			Samples added later are described with the same words
+ * @param[in] words	The number of words, 0 to drop the vocabulary and match every sample
+ */
+void Database::trainVocabulary( int words ) {
 	if( debug )
-		cerr << "\n\tMatching done. Returning the object\n\n";
+		cerr << "Training a vocabulary of " << words << " words\n";
 
-	return matchingObject;
-	
+	boost::lock_guard< boost::mutex > update( updateMutex );
+	boost::unique_lock< boost::shared_mutex > lock( samplesMutex );
+
+	if( words > 0 )
+		vocabulary.train( descriptorDB, words, backend.isBinary() );
+	else
+		vocabulary.clear();
+
+	if( vocabulary.size() < words )
+		cerr << "Only " << vocabulary.size() << " visual words out of " << words << ", there are too few descriptors\n";
+
+	saveVocabulary();
+}
+
+/**
+ * @brief	Returns the number of visual words, 0 if there's no vocabulary
+ */
+int Database::getVocabularySize() const {
+	return vocabulary.size();
+}
+
+/**
+ * @brief	Returns the number of visual words asked for when the vocabulary was
+ * 			trained, 0 if there's no vocabulary
+ * @details	It differs from getVocabularySize() when there were less descriptors than words
+ */
+int Database::getRequestedVocabularySize() const {
+	return vocabulary.getRequestedSize();
+}
+
+/**
+ * @brief	Sets how many samples are retrieved for a frame
+ * @details	Only these samples are matched against the frame, once the
+ * 			database has a vocabulary and more samples than them
+ * @param[in] count	The number of candidate samples, 0 to match every sample
+ */
+void Database::setCandidates( size_t count ) {
+	if( count == 0 )
+		count = numeric_limits< size_t >::max();
+
+	boost::unique_lock< boost::shared_mutex > lock( samplesMutex );
+	candidateCount = count;
+}
+
+/**
+ * @brief	Returns how many samples are retrieved for a frame
+ */
+size_t Database::getCandidates() const {
+	return candidateCount;
+}
+
+/**
+ * @brief	Sets how many samples are verified for a frame
+ * @details	The samples with the most votes are all verified, so a
+ * 			sample failing the verification doesn't hide the following ones
+ * @param[in] count	The number of verified samples, at least 1
+ */
+void Database::setHypotheses( size_t count ) {
+	boost::unique_lock< boost::shared_mutex > lock( samplesMutex );
+	hypothesisCount = max( count, (size_t) 1 );
+}
+
+/**
+ * @brief	Returns how many samples are verified for a frame
+ */
+size_t Database::getHypotheses() const {
+	return hypothesisCount;
+}
+
+/**
+ * @brief	Returns the name of this Database
+ */
+string Database::getName() const {
+	return dbName;
+}
+
+/**
+ * @brief	Returns the names of the samples, in the matcher order
+ */
+vector< string > Database::getSampleNames() const {
+	return nameDB;
+}
+
+/**
+ * @brief	Returns a copy of the descriptors of the samples, in the matcher order
+ * @details	Taken under the lock of the samples, so it's safe while other
+ * 			threads add or remove samples. The matrices share the data of the
+ * 			Database, mapped from its file when it was loaded: they are valid
+ * 			as long as the Database is
+ */
+vector< Mat > Database::copyDescriptors() const {
+	boost::shared_lock< boost::shared_mutex > lock( samplesMutex );
+
+	return descriptorDB;
+}
+
+/**
+ * @brief	Returns the features and matcher used by this Database
+ */
+FeatureBackend Database::getBackend() const {
+	return backend;
+}
+
+/**
+ * @brief	Returns the descriptors of every sample, in the matcher order
+ * @details	The reference isn't guarded by the lock of the samples: it must
+ * 			not be used while another thread adds or removes samples, see
+ * 			copyDescriptors() for that
+ */
+const vector< Mat >& Database::getDescriptors() const {
+	return descriptorDB;
+}
+
+/**
+ * @brief	Returns the file of the trained index
+ * @retval	The file name, empty if the matcher isn't persistent
+ */
+string Database::getIndexFileName() const {
+	return indexFileName;
+}
+
+/**
+ * @brief	Returns the time spent so far by match() in each of its stages
+ * @details	Construction is the one-time cost of building the feature
+ * 			pipeline, the other stages are summed over every match() call,
+ * 			of any thread
+ * @retval	The cumulative MatchProfile of this Database
+ */
+MatchProfile Database::getProfile() const {
+	return profile.load();
+}
+
+/**
+ * @brief	Returns the time spent building this Database
+ * @retval	The BuildProfile, with no samples if the Database was loaded
+ */
+BuildProfile Database::getBuildProfile() const {
+	return buildProfile;
 }
 
 /**
@@ -199,7 +890,10 @@ Object Database::match( Mat scene ) {
  * @details	Loaded the images contained in the argument path
  * 			associate to every image sample its keypoints and descriptors.
  * 			Also loads the label positions in the samples.
- * 			Saves everything in three structures and to a set of files
+ * 			The images are spread over a pool of threads, each with its own
+ * 			feature pipeline, and merged in file name order, so that building
+ * 			twice the same folder gives the same database.
+ * 			Saves everything in the structures and to the database file
  * @param[in] imagesPath	The path containing the source images
  */
 void Database::build( string imagesPath ) {
@@ -214,21 +908,11 @@ void Database::build( string imagesPath ) {
 
 	fs::directory_iterator end_iter;
 
-	// SIFT detector and extractor
-	Ptr< FeatureDetector > featureDetector = FeatureDetector::create( "SIFT" );
-	Ptr< DescriptorExtractor > featureExtractor = DescriptorExtractor::create( "SIFT" );
-
-	// Temporary containers
-	Mat load, descriptors;
-	vector< KeyPoint > keypoints;
+	createPipeline();
 
-	// Random color generator for label coloring
-	boost::mt19937 rng( time( 0 ) );
-	boost::uniform_int<> colorRange( 0, 255 );
-	boost::variate_generator< boost::mt19937, boost::uniform_int<> > color( rng, colorRange );
+	// The images, sorted as the directory order isn't defined
+	vector< fs::path > images;
 
-	// For every image compute descriptors, load labels and save them
-	// Associate to every label a random color for visualization
 	for( fs::directory_iterator it( fullPath ); it != end_iter; ++it ) {
 		fs::path extension = fs::extension( it -> path() );
 
@@ -239,94 +923,311 @@ void Database::build( string imagesPath ) {
 			continue;
 		}
 
-		if( debug ) {
-			cerr << "\tTreating a new image: ";
-			cerr << it -> path().stem() << endl;
-		}
-	
-		load = imread( it -> path().string() );
-		
-		// Detect the keypoints in the actual image
-		featureDetector -> detect( load, keypoints );
+		images.push_back( it -> path() );
+	}
 
-		if( debug )
-			cerr << "\tFeatures detected" << endl;
+	sort( images.begin(), images.end() );
 
-		// Compute SURF descriptors
-		featureExtractor -> compute( load, keypoints, descriptors );
+	int threads = buildThreads > 0 ? buildThreads : max( 1, (int) boost::thread::hardware_concurrency() );
+	threads = max( 1, min( threads, (int) images.size() ) );
 
-		if( debug )
-			cerr << "\tDescriptors extracted\n";
+	if( debug )
+		cerr << "\tBuilding " << images.size() << " samples with " << threads << " threads\n";
 
-		string labelName = it -> path().stem().string();
+	// Every thread takes the next image to be treated, its results go in the slot of the image
+	vector< SampleData > samples( images.size() );
+	// NOTE not a vector< bool >, whose elements can't be written concurrently
+	vector< char > valid( images.size(), false );
+	vector< BuildProfile > threadProfiles( threads );
+	atomic< size_t > next( 0 );
 
-		string labelFileName = it -> path().parent_path().string() + "/" + it -> path().stem().string() + ".lbl";
+	Clock::time_point start = Clock::now();
+	boost::thread_group workers;
 
-		ifstream loadLabels( labelFileName.c_str(), ios::in );
+	for( int t = 0; t < threads; t++ )
+		workers.create_thread( [ &, t ]() {
+			// NOTE the pipeline isn't shared, as it isn't guaranteed to be thread safe
+			Ptr< Feature2D > threadFeatures = t == 0 ? features : backend.createFeatures();
 
-		if( debug )
-			cerr << "\tLoading labels from file " << labelFileName << endl;
+			for( size_t i = next++; i < images.size(); i = next++ )
+				valid[ i ] = computeSample( images[ i ], threadFeatures, samples[ i ], threadProfiles[ t ] );
+		} );
 
-		// Read the labels associated to this image from the .lbl file
-		vector< Label > localLabels;
-		string name, x, y;
+	workers.join_all();
 
-		while( loadLabels >> name ) {
-			loadLabels >> x >> y;
+	buildProfile = BuildProfile();
+	buildProfile.threads = threads;
+	buildProfile.extraction = elapsed( start, Clock::now() );
 
-			if( debug )
-				cerr << "\t\tLoading labed " << name << " " << x << " " << y << endl;
+	for( vector< BuildProfile >::iterator it = threadProfiles.begin(); it != threadProfiles.end(); it++ ) {
+		buildProfile.reading += it -> reading;
+		buildProfile.features += it -> features;
+		buildProfile.labels += it -> labels;
+	}
 
-			localLabels.push_back( Label( name, Point2f( ::atof( ( x ).c_str() ), ::atof( ( y ).c_str() ) ), Scalar( color(), color(), color() ) ) );
-		}
+	// Random color generator for label coloring
+	boost::mt19937 rng( time( 0 ) );
+	boost::uniform_int<> colorRange( 0, 255 );
+	boost::variate_generator< boost::mt19937, boost::uniform_int<> > color( rng, colorRange );
 
-		// Add everything to the structures
-		// The association between the structure is gained by position
-		labelDB.push_back( localLabels );
+	// Add everything to the structures, in order
+	// The association between the structure is gained by position
+	// Associate to every label a random color for visualization
+	for( size_t i = 0; i < samples.size(); i++ ) {
+		if( !valid[ i ] )
+			continue;
 
-		if( debug )
-			cerr << "\tLabels loaded\n";
+		for( vector< Label >::iterator it = samples[ i ].labels.begin(); it != samples[ i ].labels.end(); it++ )
+			it -> color = Scalar( color(), color(), color() );
+
+		nameDB.push_back( samples[ i ].name );
+		labelDB.push_back( samples[ i ].labels );
+		keypointDB.push_back( samples[ i ].keypoints );
+		descriptorDB.push_back( samples[ i ].descriptors );
+	}
 
-		keypointDB.push_back( keypoints );
+	buildProfile.samples = descriptorDB.size();
 
-		descriptorDB.push_back( descriptors );
+	if( debug )
+		cerr << "\tDataBase updated" << endl;
 
+	// Now train the matcher
+	// NOTE the descriptorDB is stored anyway because it is used to train a new matcher
+	// after a Database load from file
+	start = Clock::now();
+	trainMatcher();
+	buildProfile.training = elapsed( start, Clock::now() );
+
+	// Now that the structures are filled, save them to a file for future usage
+	start = Clock::now();
+	save();
+	buildProfile.saving = elapsed( start, Clock::now() );
+}
+
+/**
+ * @brief	Computes the keypoints, descriptors and labels of a sample image
+ * @details	It doesn't touch the Database, so it can run in parallel
+ * @param[in] imagePath	The sample image, its labels are in the .lbl file with the same name
+ * @param[in] sampleFeatures	The feature pipeline to be used
+ * @param[out] sample	The sample data, labels are left without color
+ * @param[in,out] stageProfile	The profile where to add the time spent in each stage
+ * @retval	false if the image can't be read
+ */
+bool Database::computeSample( const fs::path& imagePath, const Ptr< Feature2D >& sampleFeatures, SampleData& sample, BuildProfile& stageProfile ) const {
+	if( debug )
+		cerr << "\tTreating a new image: " << imagePath.stem() << endl;
+
+	Clock::time_point stageStart = Clock::now(), stageEnd;
+
+	Mat load = imread( imagePath.string() );
+
+	stageEnd = Clock::now();
+	stageProfile.reading += elapsed( stageStart, stageEnd );
+	stageStart = stageEnd;
+
+	if( load.empty() ) {
 		if( debug )
-			cerr << "\tDataBase updated" << endl;
+			cerr << "\t" << imagePath << " can't be read, skipping..\n";
 
-		// Draw the keypoints for debug purposes
-		if( debug ) {
-			Mat outputImage;
-			drawKeypoints( load, keypoints, outputImage, Scalar( 255, 0, 0 ), DrawMatchesFlags::DEFAULT );
+		return false;
+	}
 
-			string outsbra = "keypoints_sample/" + it -> path().filename().string();
-			cerr << "\tShowing image " << outsbra << endl;
+	// Detect the keypoints in the actual image and compute their descriptors
+	( *sampleFeatures )( load, noArray(), sample.keypoints, sample.descriptors );
 
-			imwrite( outsbra, outputImage );
+	stageEnd = Clock::now();
+	stageProfile.features += elapsed( stageStart, stageEnd );
+	stageStart = stageEnd;
 
-			cerr << "\tReiterating" << endl << endl;
-		}
+	if( debug )
+		cerr << "\tFeatures detected and descriptors extracted\n";
+
+	sample.name = imagePath.stem().string();
+
+	string labelFileName = imagePath.parent_path().string() + "/" + sample.name + ".lbl";
+
+	ifstream loadLabels( labelFileName.c_str(), ios::in );
+
+	if( debug )
+		cerr << "\tLoading labels from file " << labelFileName << endl;
+
+	// Read the labels associated to this image from the .lbl file
+	string name, x, y;
+
+	while( loadLabels >> name ) {
+		loadLabels >> x >> y;
+
+		if( debug )
+			cerr << "\t\tLoading labed " << name << " " << x << " " << y << endl;
+
+		sample.labels.push_back( Label( name, Point2f( ::atof( ( x ).c_str() ), ::atof( ( y ).c_str() ) ), Scalar() ) );
 	}
 
-	// Now train the matcher
-	// NOTE the descriptorDB is stored anyway because it is used to train a new matcher
-	// after a Database load from file
-	matcher.add( descriptorDB );
-	matcher.train();
+	stageEnd = Clock::now();
+	stageProfile.labels += elapsed( stageStart, stageEnd );
 
-	// Now that the structures are filled, save them to a file for future usage
-	save();
+	if( debug )
+		cerr << "\tLabels loaded\n";
+
+	// Draw the keypoints for debug purposes
+	if( debug ) {
+		Mat outputImage;
+		drawKeypoints( load, sample.keypoints, outputImage, Scalar( 255, 0, 0 ), DrawMatchesFlags::DEFAULT );
+
+		string outsbra = "keypoints_sample/" + imagePath.filename().string();
+		cerr << "\tShowing image " << outsbra << endl;
+
+		imwrite( outsbra, outputImage );
+	}
+
+	return true;
 }
 
 /**
  * @brief	Load existing database and fill the structures
+ * @details	The database file is mapped in memory and the descriptors are
+ * 			used in place, without being copied.
+ * 			A database in the old four files format is loaded and converted
+ * @throw	DBLoadingException	If the file can't be read or is corrupted
  */
 void Database::load() {
 	if( debug )
 		cerr << "Loading database\n";
 
+	string dbFileName = dbPath + dbName + ".sbra";
+
+	try {
+		boost::interprocess::file_mapping file( dbFileName.c_str(), boost::interprocess::read_only );
+		mapping.reset( new boost::interprocess::mapped_region( file, boost::interprocess::read_only ) );
+	} catch( boost::interprocess::interprocess_exception& e ) {
+		throw DBLoadingException();
+	}
+
+	const char* base = static_cast< const char* >( mapping -> get_address() );
+	size_t size = mapping -> get_size();
+
+	if( size >= strlen( Sbra::LEGACY_MAGIC ) && !memcmp( base, Sbra::LEGACY_MAGIC, strlen( Sbra::LEGACY_MAGIC ) ) ) {
+		mapping.reset();
+		loadLegacy();
+	} else {
+		const Sbra::Header* header = reinterpret_cast< const Sbra::Header* >( base );
+
+		if( size < Sbra::HEADER_V1_SIZE
+				|| memcmp( header -> magic, Sbra::MAGIC, sizeof( Sbra::MAGIC ) )
+				|| header -> version < 1 || header -> version > Sbra::VERSION
+				|| ( header -> version >= 2 && size < sizeof( Sbra::Header ) )
+				|| header -> fileSize != size
+				|| header -> sampleTableOffset + header -> sampleCount * sizeof( Sbra::SampleEntry ) > size )
+			throw DBLoadingException();
+
+		// Version 1 files used the default FLANN parameters
+		FeatureBackend defaults;
+		int trees = header -> version >= 2 ? header -> trees : defaults.getTrees();
+		int checks = header -> version >= 2 ? header -> checks : defaults.getChecks();
+
+		backend = FeatureBackend( string( header -> features, strnlen( header -> features, sizeof( header -> features ) ) ),
+				string( header -> matcher, strnlen( header -> matcher, sizeof( header -> matcher ) ) ),
+				trees, checks );
+
+		if( debug )
+			cerr << "\tLoading " << header -> sampleCount << " samples from " << dbFileName << endl;
+
+		// Random color generator for label coloring
+		boost::mt19937 rng( time( 0 ) );
+		boost::uniform_int<> colorRange( 0, 255 );
+		boost::variate_generator< boost::mt19937, boost::uniform_int<> > color( rng, colorRange );
+
+		const Sbra::SampleEntry* table = reinterpret_cast< const Sbra::SampleEntry* >( base + header -> sampleTableOffset );
+
+		for( uint32_t i = 0; i < header -> sampleCount; i++ ) {
+			const Sbra::SampleEntry& entry = table[ i ];
+			size_t descriptorSize = (size_t) entry.descriptorRows * entry.descriptorCols * CV_ELEM_SIZE( entry.descriptorType );
+
+			if( entry.nameOffset + entry.nameLength > size
+					|| entry.labelsOffset + entry.labelCount * sizeof( Sbra::LabelRecord ) > size
+					|| entry.keypointsOffset + entry.keypointCount * sizeof( Sbra::KeypointRecord ) > size
+					|| entry.descriptorsOffset + descriptorSize > size )
+				throw DBLoadingException();
+
+			nameDB.push_back( string( base + entry.nameOffset, entry.nameLength ) );
+
+			// LabelDB
+			const Sbra::LabelRecord* labelRecords = reinterpret_cast< const Sbra::LabelRecord* >( base + entry.labelsOffset );
+			vector< Label > labels;
+
+			for( uint32_t j = 0; j < entry.labelCount; j++ ) {
+				if( labelRecords[ j ].nameOffset + labelRecords[ j ].nameLength > size )
+					throw DBLoadingException();
+
+				labels.push_back( Label( string( base + labelRecords[ j ].nameOffset, labelRecords[ j ].nameLength ),
+						Point2f( labelRecords[ j ].x, labelRecords[ j ].y ),
+						Scalar( color(), color(), color() ) ) );
+			}
+
+			labelDB.push_back( labels );
+
+			// keypointDB
+			const Sbra::KeypointRecord* keypointRecords = reinterpret_cast< const Sbra::KeypointRecord* >( base + entry.keypointsOffset );
+			vector< KeyPoint > keypoints( entry.keypointCount );
+
+			for( uint32_t j = 0; j < entry.keypointCount; j++ )
+				keypoints[ j ] = KeyPoint( keypointRecords[ j ].x, keypointRecords[ j ].y,
+						keypointRecords[ j ].size, keypointRecords[ j ].angle, keypointRecords[ j ].response,
+						keypointRecords[ j ].octave, keypointRecords[ j ].classId );
+
+			keypointDB.push_back( keypoints );
+
+			// descriptorDB. The Mat only wraps the mapped memory, that stays valid as long as the mapping
+			if( entry.descriptorRows > 0 )
+				descriptorDB.push_back( Mat( entry.descriptorRows, entry.descriptorCols, entry.descriptorType,
+							const_cast< char* >( base + entry.descriptorsOffset ) ) );
+			else
+				descriptorDB.push_back( Mat() );
+		}
+	}
+
+	if( debug )
+		cerr << "\tLoad successfull" << endl;
+
+	createPipeline();
+	trainMatcher();
+
+	if( debug )
+		cerr << "\tMatcher trained successfully" << endl;
+
+	// Convert the old format, so that the next load is a fast one
+	if( !mapping )
+		save();
+}
+
+/**
+ * @brief	Load a database saved in the old four files format
+ * @details	The format was made of the <name>.sbra marker with the backend
+ * 			metadata, a boost archive of the descriptors and two text files
+ * 			for the labels and the keypoints.
+ * 			Samples didn't have a name, so they are numbered
+ */
+void Database::loadLegacy() {
+	if( debug )
+		cerr << "\tLoading legacy database\n";
+
 	string dbFileName = dbPath + dbName;
 
+	// The backend metadata, databases without it were created with SIFT
+	ifstream meta( ( dbFileName + ".sbra" ).c_str(), ios::in );
+	string token, featuresName = "SIFT", matcherName;
+
+	meta >> token;
+
+	while( meta >> token ) {
+		if( token == "features" )
+			meta >> featuresName;
+		else if( token == "matcher" )
+			meta >> matcherName;
+	}
+
+	backend = FeatureBackend( featuresName, matcherName );
+
 	ifstream desc( ( dbFileName + "desc.sbra" ).c_str(), ios::binary );
 
 	ifstream label( ( dbFileName + "label.sbra" ).c_str(), ios::binary );
@@ -425,63 +1326,154 @@ void Database::load() {
 	if( debug )
 		cerr << "\t\tKeypoints loaded\n";
 
-	if( debug )
-		cerr << "\tLoad successfull" << endl;
-
-	matcher.add( descriptorDB );
-	matcher.train();
+	for( size_t i = 0; i < descriptorDB.size(); i++ )
+		nameDB.push_back( "sample" + boost::lexical_cast< string >( i ) );
+}
 
-	if( debug )
-		cerr << "\tMatcher trained successfully" << endl;
+/**
+ * @brief	Writes the padding needed to align the next write
+ */
+static void align( ofstream& out, size_t alignment ) {
+	for( size_t position = out.tellp(); position % alignment; position++ )
+		out.put( 0 );
 }
 
 /**
- * @brief	Writes the database to a set of files in the default directory 
+ * @brief	Writes the database to its file in the default directory
+ * @details	The file is written aside and then renamed, so that a mapping
+ * 			of the previous version stays valid and a failed save doesn't
+ * 			corrupt the database. See sbra_format.h for the layout
+ * @throw	DBSavingException	If the file can't be written
  */
 void Database::save() {
 	if( debug )
 		cerr << "Saving the created database" << endl;
 
-	string dbFileName = dbPath + dbName;
-
-	// Empty file for existence check
-	ofstream ex( ( dbFileName + ".sbra" ).c_str(), ios::out );
-	ex << "SBRA!";
-	ex.close();
-
-	ofstream desc( ( dbFileName + "desc.sbra" ).c_str(), ios::binary );
+	string dbFileName = dbPath + dbName + ".sbra";
+	string tempFileName = dbFileName + ".tmp";
 
-	ofstream label( ( dbFileName + "label.sbra" ).c_str(), ios::binary );
-	ofstream kp( ( dbFileName + "kp.sbra" ).c_str(), ios::out );
+	ofstream out( tempFileName.c_str(), ios::binary | ios::trunc );
 
-	if( label.fail() || kp.fail() || desc.fail() )
+	if( out.fail() )
 		throw DBSavingException();
 	else if( debug )
 		cerr << "\tSaving to " << dbFileName << endl;
 
-	boost::archive::binary_oarchive descarch( desc );
-	descarch << descriptorDB;
+	Sbra::Header header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, Sbra::MAGIC, sizeof( Sbra::MAGIC ) );
+	header.version = Sbra::VERSION;
+	header.sampleCount = descriptorDB.size();
+	strncpy( header.features, backend.getFeaturesName().c_str(), sizeof( header.features ) );
+	strncpy( header.matcher, backend.getMatcherName().c_str(), sizeof( header.matcher ) );
+	header.trees = backend.getTrees();
+	header.checks = backend.getChecks();
+
+	// Placeholder, rewritten once the offsets are known
+	out.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+
+	vector< Sbra::SampleEntry > table( descriptorDB.size() );
+
+	// descriptorDB, every block aligned so that it can be used in place after mapping
+	for( size_t i = 0; i < descriptorDB.size(); i++ ) {
+		const Mat& descriptors = descriptorDB[ i ];
+
+		align( out, Sbra::ALIGNMENT );
+
+		table[ i ].descriptorsOffset = out.tellp();
+		table[ i ].descriptorRows = descriptors.rows;
+		table[ i ].descriptorCols = descriptors.cols;
+		table[ i ].descriptorType = descriptors.type();
+
+		if( descriptors.isContinuous() )
+			out.write( reinterpret_cast< const char* >( descriptors.data ), descriptors.total() * descriptors.elemSize() );
+		else
+			for( int r = 0; r < descriptors.rows; r++ )
+				out.write( reinterpret_cast< const char* >( descriptors.ptr( r ) ), descriptors.cols * descriptors.elemSize() );
+	}
 
-	// labelDB
-	for( vector< vector< Label > >::iterator it = labelDB.begin(); it != labelDB.end(); it++ ) {
-		label << "Sample" << endl;
+	// keypointDB
+	align( out, sizeof( uint64_t ) );
+
+	for( size_t i = 0; i < keypointDB.size(); i++ ) {
+		table[ i ].keypointsOffset = out.tellp();
+		table[ i ].keypointCount = keypointDB[ i ].size();
 
-		for( vector< Label >::iterator jt = ( *it ).begin(); jt != ( *it ).end(); jt++ )
-			label << ( *jt ).name << " " << ( *jt ).position.x << " " << ( *jt ).position.y << endl;
+		for( vector< KeyPoint >::iterator jt = keypointDB[ i ].begin(); jt != keypointDB[ i ].end(); jt++ ) {
+			Sbra::KeypointRecord record = { jt -> pt.x, jt -> pt.y, jt -> size, jt -> angle, jt -> response, jt -> octave, jt -> class_id };
+			out.write( reinterpret_cast< const char* >( &record ), sizeof( record ) );
+		}
 	}
 
-	// keypointDB
-	for( vector< vector< KeyPoint > >::iterator it = keypointDB.begin(); it != keypointDB.end(); it++ ) {
-		kp << "Sample" << endl;
+	// Strings area, with the sample names followed by their label names
+	vector< vector< uint64_t > > labelNameOffsets( labelDB.size() );
+
+	for( size_t i = 0; i < nameDB.size(); i++ ) {
+		table[ i ].nameOffset = out.tellp();
+		table[ i ].nameLength = nameDB[ i ].size();
+		out.write( nameDB[ i ].data(), nameDB[ i ].size() );
 
-		for( vector< KeyPoint >::iterator jt = ( *it ).begin(); jt != ( *it ).end(); jt++ )
-			kp << ( *jt ).pt.x << " " << ( *jt ).pt.y << " " << ( *jt ).size << " " << ( *jt ).angle << " " << ( *jt ).response << " " << ( *jt ).octave << " " << ( *jt ).class_id << endl;
+		for( vector< Label >::iterator jt = labelDB[ i ].begin(); jt != labelDB[ i ].end(); jt++ ) {
+			labelNameOffsets[ i ].push_back( out.tellp() );
+			out.write( jt -> name.data(), jt -> name.size() );
+		}
 	}
-	
-	label.close();
-	desc.close();
-	kp.close();
+
+	// labelDB
+	align( out, sizeof( uint64_t ) );
+
+	for( size_t i = 0; i < labelDB.size(); i++ ) {
+		table[ i ].labelsOffset = out.tellp();
+		table[ i ].labelCount = labelDB[ i ].size();
+
+		for( size_t j = 0; j < labelDB[ i ].size(); j++ ) {
+			Sbra::LabelRecord record = { labelDB[ i ][ j ].position.x, labelDB[ i ][ j ].position.y,
+					labelNameOffsets[ i ][ j ], (uint32_t) labelDB[ i ][ j ].name.size(), 0 };
+			out.write( reinterpret_cast< const char* >( &record ), sizeof( record ) );
+		}
+	}
+
+	// Sample table and final header
+	align( out, sizeof( uint64_t ) );
+
+	header.sampleTableOffset = out.tellp();
+
+	if( !table.empty() )
+		out.write( reinterpret_cast< const char* >( &table[ 0 ] ), table.size() * sizeof( Sbra::SampleEntry ) );
+
+	header.fileSize = out.tellp();
+
+	out.seekp( 0 );
+	out.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+	out.close();
+
+	if( out.fail() )
+		throw DBSavingException();
+
+	boost::system::error_code error;
+	fs::rename( tempFileName, dbFileName, error );
+
+	if( error )
+		throw DBSavingException();
 
 	if( debug )
 		cerr << "\tSave successfull" << endl;
 }
+
+/**
+ * @brief	Writes the vocabulary next to the database file
+ * @details	An empty vocabulary removes the file
+ */
+void Database::saveVocabulary() {
+	string vocabularyFileName = dbPath + dbName + ".bow";
+
+	if( vocabulary.empty() ) {
+		fs::remove( vocabularyFileName );
+		return;
+	}
+
+	if( !vocabulary.save( vocabularyFileName, nameDB ) )
+		throw DBSavingException();
+	else if( debug )
+		cerr << "\tVocabulary saved to " << vocabularyFileName << endl;
+}
@@ -15,9 +15,21 @@
 #include <vector>
 #include <string>
 #include <numeric>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <cfloat>
+#include <cctype>
 
 // Custom header files
 #include "object.h"
+#include "feature_backend.h"
+#include "vocabulary.h"
+#include "sbra_format.h"
+#include "recognition_pool.h"
 
 // OpenCV libraries
 #include "opencv2/core/core.hpp"
@@ -43,33 +55,251 @@
 
 #include "boost/lexical_cast.hpp"
 
+#include "boost/shared_ptr.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+#include "boost/crc.hpp"
+
+#include "boost/thread.hpp"
+
+#include "boost/chrono.hpp"
+
 extern bool debug;
 
 namespace IStuff {
+	/**
+	 * @brief Cumulative time spent by Database::match in each of its stages, in seconds
+	 */
+	struct MatchProfile {
+		size_t calls;
+		double construction;
+		double resize;
+		double features;
+		double retrieval;
+		double matching;
+		double homography;
+
+		MatchProfile()
+			: calls( 0 ), construction( 0 ), resize( 0 ), features( 0 ), retrieval( 0 ), matching( 0 ), homography( 0 )
+		{}
+	};
+
+	/**
+	 * @brief Time spent building a Database, in seconds
+	 * @details Reading, features and labels are summed over the build threads,
+	 * 		so their sum against extraction, the wall time of the parallel
+	 * 		stage, gives the speedup over a serial build
+	 */
+	struct BuildProfile {
+		size_t samples;
+		int threads;
+		double reading;
+		double features;
+		double labels;
+		double extraction;
+		double training;
+		double saving;
+
+		BuildProfile()
+			: samples( 0 ), threads( 0 ), reading( 0 ), features( 0 ), labels( 0 ), extraction( 0 ), training( 0 ), saving( 0 )
+		{}
+	};
+
+	/**
+	 * @brief Everything a Database stores about a sample image
+	 */
+	struct SampleData {
+		std::string name;
+		std::vector< Label > labels;
+		std::vector< cv::KeyPoint > keypoints;
+		cv::Mat descriptors;
+	};
+
+	/**
+	 * @brief A sample verified against a frame, with the outcome of the verification
+	 */
+	struct Hypothesis {
+		int sample;
+		int votes;
+		bool verified;
+		int inliersCount;
+		cv::Mat homography;
+		// Bounding box of the inliers in the frame
+		cv::Rect area;
+
+		// Scratch buffers, kept between the frames
+		std::vector< cv::Point2f > samplePoints, scenePoints;
+		std::vector< uchar > inliers;
+
+		Hypothesis()
+			: sample( -1 ), votes( 0 ), verified( false ), inliersCount( 0 )
+		{}
+	};
+
+	class Database;
+
+	/**
+	 * @brief	Everything a Database::matchAll() call writes
+	 * @details	The buffers are kept between the calls made with the same
+	 * 			context, so that they aren't reallocated every frame. A context
+	 * 			can't be used by two calls at the same time, a Database can
+	 */
+	struct MatchContext {
+		cv::Mat scaledScene;
+		std::vector< cv::KeyPoint > sceneKeypoints;
+		cv::Mat sceneDescriptors;
+		std::vector< int > candidates;
+		std::vector< cv::Mat > candidateDescriptors;
+		cv::Ptr< cv::DescriptorMatcher > candidateMatcher;
+		// The feature pipeline of the context: it isn't guaranteed to be thread safe
+		cv::Ptr< cv::Feature2D > features;
+		std::vector< std::vector< cv::DMatch > > matches;
+		std::vector< cv::DMatch > goodMatches;
+		std::vector< int > votes;
+		std::vector< std::pair< int, int > > ranking;
+
+		// Samples with the most votes verified for the frame
+		std::vector< Hypothesis > hypotheses;
+
+		// Stage times of the current call
+		MatchProfile profile;
+
+		// The Database the candidateMatcher, a brute force one, and the features were made for, and the number of this context in it
+		const Database* owner;
+		size_t id;
+
+		MatchContext()
+			: owner( NULL ), id( 0 )
+		{}
+	};
+
+	/**
+	 * @brief	MatchProfile summed over concurrent matches without locking
+	 */
+	struct AtomicMatchProfile {
+		std::atomic< size_t > calls;
+		// Written once, before any match
+		double construction;
+		std::atomic< double > resize;
+		std::atomic< double > features;
+		std::atomic< double > retrieval;
+		std::atomic< double > matching;
+		std::atomic< double > homography;
+
+		AtomicMatchProfile()
+			: calls( 0 ), construction( 0 ), resize( 0 ), features( 0 ), retrieval( 0 ), matching( 0 ), homography( 0 )
+		{}
+
+		void add( const MatchProfile& );
+		MatchProfile load() const;
+	};
+
 	class Database {
 		private:
 			const float NNDR_RATIO = 0.6;
 			const float MIN_INLIER_RATIO = 0.5;
 			const int MATCH_THRESHOLD = 20;
+			// Fraction of the smaller area two objects found in the same frame may share
+			const float MAX_OVERLAP = 0.5;
 
 			std::string dbPath;
 			std::string dbName;
 
-			cv::FlannBasedMatcher matcher;
+			FeatureBackend backend;
+
+			// knnMatch() isn't const only because it trains the matcher on the descriptors
+			// added since the last training: trainMatcher() always leaves it trained, so
+			// concurrent matches only read it
+			mutable cv::Ptr< cv::DescriptorMatcher > matcher;
+			std::vector< std::string > nameDB;
 			std::vector< std::vector< Label > > labelDB;
 			std::vector< std::vector< cv::KeyPoint > > keypointDB;
 			std::vector< cv::Mat > descriptorDB;
 
+			// Mapping of the database file, the loaded descriptors point into it
+			boost::shared_ptr< boost::interprocess::mapped_region > mapping;
+
+			// File of the trained index of the current descriptors, if the matcher is persistent
+			std::string indexFileName;
+
+			// Feature pipeline of the backend, built once and used by a thread of build().
+			// Detection and description are done in a single pass. It isn't guaranteed to be
+			// thread safe, so every MatchContext and every update has its own
+			cv::Ptr< cv::Feature2D > features;
+
+			// Frames are downscaled by this factor before being matched
+			float recognitionScale;
+
+			// Visual words of the samples; when trained only the candidateCount samples
+			// most similar to the frame are matched, by the candidateMatcher of the MatchContext
+			Vocabulary vocabulary;
+			size_t candidateCount;
+
+			// Samples with the most votes verified for each frame
+			size_t hypothesisCount;
+
+			// Everything match() writes is in a MatchContext, so matches share this lock
+			// and changes to the samples or the settings take it exclusively
+			mutable boost::shared_mutex samplesMutex;
+			// Changes to the samples are serialized by this lock, so that they can read the
+			// samples without samplesMutex and prepare the new ones while matches go on
+			boost::mutex updateMutex;
+			mutable std::atomic< size_t > contextCount;
+
+			AtomicMatchProfile profile;
+
+			// Threads used to build the database, 0 for one per core
+			int buildThreads;
+			BuildProfile buildProfile;
+
 		public:
-			Database( std::string, std::string );
+			Database( std::string, std::string, FeatureBackend = FeatureBackend(), int = 0 );
 			virtual ~Database();
 
-			Object match( cv::Mat );
+			Object match( cv::Mat ) const;
+			std::vector< Object > matchAll( cv::Mat, size_t = std::numeric_limits< size_t >::max() ) const;
+			std::vector< Object > matchAll( MatchContext&, cv::Mat, size_t = std::numeric_limits< size_t >::max() ) const;
+
+			bool addSample( std::string );
+			bool removeSample( std::string );
+			bool updateSamples( const std::vector< std::string >&, const std::vector< std::string >&, std::vector< std::string >& );
+
+			void setRecognitionScale( float );
+			float getRecognitionScale() const;
+
+			void trainVocabulary( int );
+			int getVocabularySize() const;
+			int getRequestedVocabularySize() const;
+			void setCandidates( size_t );
+			size_t getCandidates() const;
+			void setHypotheses( size_t );
+			size_t getHypotheses() const;
+
+			std::string getName() const;
+			std::vector< std::string > getSampleNames() const;
+			std::vector< cv::Mat > copyDescriptors() const;
+			FeatureBackend getBackend() const;
+			const std::vector< cv::Mat >& getDescriptors() const;
+			std::string getIndexFileName() const;
+			MatchProfile getProfile() const;
+			BuildProfile getBuildProfile() const;
 
 		private:
+			class HypothesisVerifier;
+
+			void verify( const MatchContext&, Hypothesis& ) const;
+			Object labelObject( const Hypothesis& ) const;
+			void createPipeline();
+			void trainMatcher();
+			void trainMatcher( cv::Ptr< cv::DescriptorMatcher >&, const std::vector< cv::Mat >&, std::string& ) const;
+			std::string indexChecksum( const std::vector< cv::Mat >& ) const;
 			void build( std::string );
+			bool computeSample( const boost::filesystem::path&, const cv::Ptr< cv::Feature2D >&, SampleData&, BuildProfile& ) const;
 			void load();
+			void loadLegacy();
 			void save();
+			void saveVocabulary();
 	};
 
 	class DBCreationException: public std::exception {
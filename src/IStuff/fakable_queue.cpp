@@ -1,22 +1,26 @@
 /**
  * @file fakable_queue.cpp
  * @class IStuff::FakableQueue
- * @brief Class used to manage a synchronized double queue.
+ * @brief Class used to manage a lock free queue of frames with a replay point.
  * @details This class is used by IStuff::Tracker and it allows to address
  *  problems caused by alternated recognizations:<br />
- *  This queue manages two queues: one "real", used normally, from where frames
- *  are enqueued and dequeued and one "fake", or "saved", used to store the
- *  frames regarding only the last recognization, where frames are just enqueued
- *  and which is substituted to the real queue when the last recognization ends.
+ *  Frames are enqueued and dequeued normally, but the queue remembers the
+ *  frame that started the last recognization: discarding the queue makes it
+ *  read again every frame from that one on, as if they were never dequeued.<br />
+ *  The queue is a ring of preallocated slots with a single producer, enqueuing
+ *  and starting, and a single consumer, dequeuing and discarding; neither of
+ *  them ever waits for the other. The frames from the starter on are never
+ *  overwritten, so when the ring is full new frames are dropped.<br />
+ *  Starting and discarding must not overlap, as it happens when the queue is
+ *  started at the beginning of a recognization and discarded at its end.
  * @author Maurizio Zucchelli
- * @version 0.1.2
+ * @version 0.2.0
  * @date 2013-07-18
  */
 
 #include "fakable_queue.h"
 
 using namespace std;
-using namespace boost;
 using namespace cv;
 using namespace IStuff;
 
@@ -26,8 +30,12 @@ const char FakableQueue::TAG[] = "Fkq";
 
 /**
  * @brief Constructor of this class.
+ *
+ * @param[in] capacity  The number of frames the queue can hold.
  */
-FakableQueue::FakableQueue()
+FakableQueue::FakableQueue(size_t capacity)
+  : slots(max(capacity, (size_t) 1)),
+    head(0), tail(0), saved(0), started(false), dropped(0)
 {}
 
 FakableQueue::~FakableQueue()
@@ -37,49 +45,85 @@ FakableQueue::~FakableQueue()
 
 /**
  * @brief Adds a frame to the queue.
- * @details If the queue has been started, the frame is added to both the 'real'
- *  and the 'saved' queue; otherwise, nothing happens.
+ * @details If the queue has been started, the frame is added to its end;
+ *  otherwise, nothing happens.
  *
  * @param[in] frame  The frame to be inserted.
+ *
+ * @return `true` if the frame is enqueued, `false` if the queue isn't started
+ *  or it's full.
  */
-void FakableQueue::enqueue(Mat frame)
+bool FakableQueue::enqueue(Mat frame)
 {
   if (debug)
     cerr << TAG << ": enqueue.\n";
 
-  lock_guard<mutex> lock(queue_mutex);
+  if (!started.load(memory_order_acquire))
+    return false;
 
-  if (real_queue.empty())
-    return;
-  else
+  size_t position = head.load(memory_order_relaxed),
+         oldest = min(tail.load(memory_order_acquire),
+                      saved.load(memory_order_relaxed));
+
+  if (position - oldest >= slots.size())
   {
-    real_queue.push(frame);
-    saved_queue.push(frame);
+    dropped.fetch_add(1, memory_order_relaxed);
+    return false;
   }
+
+  slots[position % slots.size()] = frame;
+  head.store(position + 1, memory_order_release);
+
+  return true;
 }
 
 /**
- * @brief Starts the queue, enabiling the enqueuement.
- * @details This operation resets the 'saved' queue and then performs an
- *  enqueue with the given frame.
+ * @brief Starts the queue, enabling the enqueuement.
+ * @details The given frame is enqueued and becomes the point where the queue
+ *  goes back when discarded.
  *
  * @param[in] frame  The frame starter of the queue.
+ *
+ * @return `false` if the queue is full, in which case it stays stopped.
  */
-void FakableQueue::start(Mat frame)
+bool FakableQueue::start(Mat frame)
 {
   if (debug)
     cerr << TAG << ": start.\n";
 
-  lock_guard<mutex> lock(queue_mutex);
+  started.store(false, memory_order_release);
 
-  saved_queue = queue<Mat>();
+  size_t position = head.load(memory_order_relaxed);
+
+  if (position - tail.load(memory_order_acquire) >= slots.size())
+  {
+    dropped.fetch_add(1, memory_order_relaxed);
+    return false;
+  }
+
+  slots[position % slots.size()] = frame;
+  saved.store(position, memory_order_release);
+  head.store(position + 1, memory_order_release);
+  started.store(true, memory_order_release);
+
+  return true;
+}
+
+/**
+ * @brief Stops the queue: the following frames aren't enqueued until it's
+ *  started again.
+ */
+void FakableQueue::stop()
+{
+  if (debug)
+    cerr << TAG << ": stop.\n";
 
-  real_queue.push(frame);
-  saved_queue.push(frame);
+  started.store(false, memory_order_release);
 }
 
 /**
- * @brief Replaces the 'real' queue with the 'saved' one.
+ * @brief Makes the queue read again every frame from its starter on.
+ * @details Nothing is copied, only the read position is moved back.
  * @todo Find a more explicative name.
  */
 void FakableQueue::discard()
@@ -87,35 +131,74 @@ void FakableQueue::discard()
   if (debug)
     cerr << TAG << ": discard.\n";
 
-  lock_guard<mutex> lock(queue_mutex);
+  tail.store(saved.load(memory_order_acquire), memory_order_release);
+}
+
+/**
+ * @brief Drops every frame, the ones to be replayed too.
+ * @details The frames are released, so their buffers can be reused. Like
+ *  discard(), this must not overlap start().
+ */
+void FakableQueue::clear()
+{
+  if (debug)
+    cerr << TAG << ": clear.\n";
 
-  real_queue = saved_queue;
+  size_t position = min(tail.load(memory_order_relaxed),
+                        saved.load(memory_order_acquire)),
+         end = head.load(memory_order_acquire);
+
+  for (; position != end; position++)
+    slots[position % slots.size()].release();
+
+  saved.store(end, memory_order_release);
+  tail.store(end, memory_order_release);
 }
 
 /* Getters */
 
 /**
- * @brief Returns and removes a frame from the 'real' queue.
+ * @brief Returns and removes the frame in front of the queue.
  * @throw out_of_range If the queue is empty.
  *
- * @return The frame in front of the 'real' queue.
+ * @return The frame in front of the queue.
  */
 Mat FakableQueue::dequeue()
+{
+  Mat result;
+
+  if (!tryDequeue(result))
+    throw out_of_range("FakableQueue empty");
+
+  return result;
+}
+
+/**
+ * @brief Removes the frame in front of the queue, if there is one.
+ *
+ * @param[out] frame  The frame in front of the queue.
+ *
+ * @return `false` if the queue is empty.
+ */
+bool FakableQueue::tryDequeue(Mat& frame)
 {
   if (debug)
     cerr << TAG << ": dequeue.\n";
 
-  Mat result;
+  size_t position = tail.load(memory_order_relaxed);
 
-  lock_guard<mutex> lock(queue_mutex);
+  if (position == head.load(memory_order_acquire))
+    return false;
 
-  if (real_queue.empty())
-    throw out_of_range("FakableQueue empty");
+  frame = slots[position % slots.size()];
 
-  result = real_queue.front();
-  real_queue.pop();
+  // Frames before the starter won't be read again, their memory can go
+  if (position < saved.load(memory_order_acquire))
+    slots[position % slots.size()].release();
 
-  return result;
+  tail.store(position + 1, memory_order_release);
+
+  return true;
 }
 
 /**
@@ -128,9 +211,40 @@ Mat FakableQueue::getStarter()
   if (debug)
     cerr << TAG << ": getStarter.\n";
 
-  // Could be shared...
-  lock_guard<mutex> lock(queue_mutex);
+  return slots[saved.load(memory_order_acquire) % slots.size()];
+}
+
+/**
+ * @brief Checks whether frames are being enqueued.
+ */
+bool FakableQueue::isStarted() const
+{
+  return started.load(memory_order_acquire);
+}
+
+/**
+ * @brief Returns the number of frames waiting to be dequeued.
+ */
+size_t FakableQueue::size() const
+{
+  // The tail is read first, so that it can't overtake the head
+  size_t position = tail.load(memory_order_acquire);
 
-  return saved_queue.front();
+  return head.load(memory_order_acquire) - position;
 }
 
+/**
+ * @brief Returns the number of frames the queue can hold.
+ */
+size_t FakableQueue::capacity() const
+{
+  return slots.size();
+}
+
+/**
+ * @brief Returns the number of frames dropped because the queue was full.
+ */
+size_t FakableQueue::getDropped() const
+{
+  return dropped.load(memory_order_relaxed);
+}
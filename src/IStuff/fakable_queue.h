@@ -2,7 +2,7 @@
  * @file fakable_queue.h
  * @brief Header file for IStuff::FakableQueue.
  * @author Maurizio Zucchelli
- * @version 0.1.0
+ * @version 0.2.0
  * @date 2013-07-18
  */
 
@@ -10,9 +10,10 @@
 #define I_STUFF_FAKABLE_QUEUE_H__
 
 #include <iostream>
-#include <queue>
-
-#include <boost/thread.hpp>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
 
 #include "opencv2/core/core.hpp"
 
@@ -25,25 +26,46 @@ namespace IStuff
     /* Attributes */
     private:
       const static char TAG[];
+      const static size_t DEFAULT_CAPACITY = 128;
+
+      /**
+       * @brief Preallocated frame slots, indexed modulo their number.
+       */
+      std::vector<cv::Mat> slots;
 
-      std::queue<cv::Mat> real_queue,
-                          saved_queue;
-      boost::mutex queue_mutex;
+      /**
+       * @brief Counters of the frames written (head) and read (tail), and
+       *  position of the frame that started the queue (saved).
+       * @details head and saved are written only by the producer, tail only by
+       *  the consumer; clear() moves saved too, but never while starting.
+       */
+      std::atomic<size_t> head,
+                          tail,
+                          saved;
+      std::atomic<bool> started;
+      std::atomic<size_t> dropped;
 
       /* Methods */
     public:
       /* Constructors and Destructors */
-      FakableQueue();
+      FakableQueue(size_t = DEFAULT_CAPACITY);
       virtual ~FakableQueue();
 
       /* Setters */
-      void enqueue(cv::Mat);
-      void start(cv::Mat);
+      bool enqueue(cv::Mat);
+      bool start(cv::Mat);
+      void stop();
       void discard();
+      void clear();
 
       /* Getters */
       cv::Mat dequeue();
+      bool tryDequeue(cv::Mat&);
       cv::Mat getStarter();
+      bool isStarted() const;
+      size_t size() const;
+      size_t capacity() const;
+      size_t getDropped() const;
   };
 }
 
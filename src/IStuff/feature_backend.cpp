@@ -0,0 +1,136 @@
+/**
+ * @file	feature_backend.cpp
+ * @brief	Definition for FeatureBackend class
+ * @class	IStuff::FeatureBackend
+ * @details	A FeatureBackend describes how a Database computes and matches
+ * 			its descriptors.
+ * 			Features can be SIFT or SURF, with float descriptors, or ORB or
+ * 			BRISK, with binary descriptors.
+ * 			Float descriptors are matched with a FLANN kd-tree forest
+ * 			("KDTree"), binary ones with FLANN LSH ("LSH"); both can also be
+ * 			matched with an exhaustive search ("BruteForce"), using the L2 or
+ * 			the Hamming distance respectively.
+ * 			The FLANN matchers use the given number of randomized trees (for
+ * 			the kd-tree forest only) and of checks per search
+ * @version	0.1.0
+ * @date	2026-10-16
+ */
+
+#include "feature_backend.h"
+
+using namespace std;
+using namespace cv;
+using namespace IStuff;
+
+/**
+ * @brief	Constructor
+ * @param[in] _featuresName	The name of the features to be used
+ * @param[in] _matcherName	The name of the matcher to be used, if empty
+ * 			the default one for the features is chosen
+ * @param[in] _trees	The number of trees of the kd-tree forest
+ * @param[in] _checks	The number of leaves checked by every FLANN search
+ * @throw	DBBackendException	If the features or the matcher are unknown,
+ * 			if the matcher can't handle the features descriptors or if the
+ * 			parameters aren't positive
+ */
+FeatureBackend::FeatureBackend( string _featuresName, string _matcherName, int _trees, int _checks ) :
+	featuresName( _featuresName ), matcherName( _matcherName ), trees( _trees ), checks( _checks )
+{
+	if( featuresName != "SIFT" && featuresName != "SURF" && featuresName != "ORB" && featuresName != "BRISK" )
+		throw DBBackendException();
+
+	if( matcherName.empty() )
+		matcherName = isBinary() ? "LSH" : "KDTree";
+
+	if( !( matcherName == "BruteForce" || ( matcherName == "KDTree" && !isBinary() ) || ( matcherName == "LSH" && isBinary() ) ) )
+		throw DBBackendException();
+
+	if( trees <= 0 || checks <= 0 )
+		throw DBBackendException();
+}
+
+/**
+ * @brief	Destructor
+ */
+FeatureBackend::~FeatureBackend() {
+
+}
+
+/**
+ * @brief	Returns the name of the features
+ */
+string FeatureBackend::getFeaturesName() const {
+	return featuresName;
+}
+
+/**
+ * @brief	Returns the name of the matcher
+ */
+string FeatureBackend::getMatcherName() const {
+	return matcherName;
+}
+
+/**
+ * @brief	Returns the number of trees of the kd-tree forest
+ */
+int FeatureBackend::getTrees() const {
+	return trees;
+}
+
+/**
+ * @brief	Returns the number of leaves checked by every FLANN search
+ */
+int FeatureBackend::getChecks() const {
+	return checks;
+}
+
+/**
+ * @brief	Tells whether the features have binary descriptors
+ * @retval	true for ORB and BRISK, false for SIFT and SURF
+ */
+bool FeatureBackend::isBinary() const {
+	return featuresName == "ORB" || featuresName == "BRISK";
+}
+
+/**
+ * @brief	Tells whether the trained matcher can be saved and loaded back
+ * @details	Only the kd-tree forest is: FLANN doesn't serialize the LSH
+ * 			tables, which are cheap to build anyway, and the brute force
+ * 			matcher has no index at all
+ * @retval	true if createMatcher() returns a PersistentFlannMatcher
+ */
+bool FeatureBackend::isPersistent() const {
+	return matcherName == "KDTree";
+}
+
+/**
+ * @brief	Creates the detector and extractor of the features
+ * @retval	A Feature2D computing keypoints and descriptors in a single pass
+ */
+Ptr< Feature2D > FeatureBackend::createFeatures() const {
+	initModule_nonfree();
+
+	return Feature2D::create( featuresName );
+}
+
+/**
+ * @brief	Creates a new, untrained, matcher for the descriptors of the features
+ */
+Ptr< DescriptorMatcher > FeatureBackend::createMatcher() const {
+	if( matcherName == "BruteForce" )
+		return new BFMatcher( isBinary() ? NORM_HAMMING : NORM_L2 );
+
+	if( matcherName == "LSH" )
+		return new FlannBasedMatcher( new flann::LshIndexParams( 12, 20, 2 ), new flann::SearchParams( checks ) );
+
+	return new PersistentFlannMatcher( new flann::KDTreeIndexParams( trees ), new flann::SearchParams( checks ) );
+}
+
+/**
+ * @brief	Creates an exhaustive matcher for the descriptors of the features
+ * @details	It needs no training, so it suits descriptors changing at every
+ * 			match, as the ones of the candidate samples of a frame
+ */
+Ptr< DescriptorMatcher > FeatureBackend::createBruteForceMatcher() const {
+	return new BFMatcher( isBinary() ? NORM_HAMMING : NORM_L2 );
+}
@@ -0,0 +1,54 @@
+/**
+* @file feature_backend.h
+* @brief Library for FeatureBackend class
+* @version 0.1.0
+* @date 2026-10-16
+*/
+
+#ifndef FEATURE_BACKEND_H__
+#define FEATURE_BACKEND_H__
+
+// Standard C++ libraries
+#include <string>
+
+// OpenCV libraries
+#include "opencv2/core/core.hpp"
+#include "opencv2/features2d/features2d.hpp"
+#include "opencv2/flann/flann.hpp"
+#include "opencv2/nonfree/nonfree.hpp"
+
+// Custom header files
+#include "persistent_matcher.h"
+
+namespace IStuff {
+	class FeatureBackend {
+		private:
+			std::string featuresName;
+			std::string matcherName;
+			int trees;
+			int checks;
+
+		public:
+			FeatureBackend( std::string = "SIFT", std::string = "", int = 4, int = 32 );
+			virtual ~FeatureBackend();
+
+			std::string getFeaturesName() const;
+			std::string getMatcherName() const;
+			int getTrees() const;
+			int getChecks() const;
+			bool isBinary() const;
+			bool isPersistent() const;
+
+			cv::Ptr< cv::Feature2D > createFeatures() const;
+			cv::Ptr< cv::DescriptorMatcher > createMatcher() const;
+			cv::Ptr< cv::DescriptorMatcher > createBruteForceMatcher() const;
+	};
+
+	class DBBackendException: public std::exception {
+		public: virtual const char* what() const throw() {
+			return "***Error in Database backend, unknown features or matcher, matcher not suited to the features or invalid matcher parameters***\n";
+		}
+	};
+};
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ * @file feature_table.cpp
+ * @class IStuff::FeatureTable
+ * @brief Class used to keep the features tracked by IStuff::Tracker.
+ * @details Every feature has an identifier, its position in the last frame
+ *  and the one it had when it was saved, i.e. detected. The fields are stored
+ *  one per array, so that the positions can be given to the optical flow as
+ *  they are.<br />
+ *  Identifiers are given in increasing order and the lost features are
+ *  removed in a single pass that keeps the order of the others: a feature
+ *  can be found by its identifier with a binary search.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#include "feature_table.h"
+
+using namespace std;
+using namespace cv;
+using namespace IStuff;
+
+/* Constructors and Destructors */
+
+FeatureTable::FeatureTable()
+  : m_next_id(0)
+{}
+
+FeatureTable::~FeatureTable()
+{}
+
+/* Setters */
+
+/**
+ * @brief Replaces the features with newly detected ones.
+ *
+ * @param[in] positions  The positions of the features, saved as well.
+ */
+void FeatureTable::assign(const vector<Point2f>& positions)
+{
+  m_ids.resize(positions.size());
+  for (size_t i = 0; i < positions.size(); i++)
+    m_ids[i] = m_next_id++;
+
+  m_positions = positions;
+  m_saved = positions;
+}
+
+/**
+ * @brief Adds a newly detected feature.
+ *
+ * @param[in] position  The position of the feature, saved as well.
+ */
+void FeatureTable::add(Point2f position)
+{
+  m_ids.push_back(m_next_id++);
+  m_positions.push_back(position);
+  m_saved.push_back(position);
+}
+
+/**
+ * @brief Moves every feature.
+ * @throw invalid_argument If the positions aren't one per feature.
+ *
+ * @param[in,out] positions  The new positions, in the order of the features;
+ *  swapped with the old ones, which are returned.
+ */
+void FeatureTable::setPositions(vector<Point2f>& positions)
+{
+  if (positions.size() != m_positions.size())
+    throw invalid_argument("FeatureTable positions count mismatch");
+
+  m_positions.swap(positions);
+}
+
+/**
+ * @brief Removes the features lost, keeping the order of the others.
+ * @details Every array is compacted in the same single pass.
+ *
+ * @param[in]     status   Whether every feature is kept, as given by
+ *  calcOpticalFlowPyrLK.
+ * @param[in,out] in_step  Values in step with the features, compacted with
+ *  them (optional).
+ *
+ * @return The number of features removed.
+ */
+size_t FeatureTable::compact(const vector<uchar>& status,
+                             vector<Point2f>* in_step)
+{
+  size_t count = min(status.size(), m_ids.size()),
+         kept = 0;
+
+  for (size_t i = 0; i < count; i++)
+    if (status[i])
+    {
+      if (kept != i)
+      {
+        m_ids[kept] = m_ids[i];
+        m_positions[kept] = m_positions[i];
+        m_saved[kept] = m_saved[i];
+
+        if (in_step)
+          (*in_step)[kept] = (*in_step)[i];
+      }
+
+      kept++;
+    }
+
+  size_t removed = m_ids.size() - kept;
+
+  m_ids.resize(kept);
+  m_positions.resize(kept);
+  m_saved.resize(kept);
+
+  if (in_step)
+    in_step->resize(kept);
+
+  return removed;
+}
+
+/**
+ * @brief Removes every feature.
+ * @details Identifiers aren't given again.
+ */
+void FeatureTable::clear()
+{
+  m_ids.clear();
+  m_positions.clear();
+  m_saved.clear();
+}
+
+/* Getters */
+
+/**
+ * @brief Returns the number of features.
+ */
+size_t FeatureTable::size() const
+{
+  return m_ids.size();
+}
+
+/**
+ * @brief Checks whether there are no features.
+ */
+bool FeatureTable::empty() const
+{
+  return m_ids.empty();
+}
+
+/**
+ * @brief Returns the identifiers of the features, increasing.
+ */
+const vector<size_t>& FeatureTable::getIds() const
+{
+  return m_ids;
+}
+
+/**
+ * @brief Returns the positions of the features in the last frame.
+ */
+const vector<Point2f>& FeatureTable::getPositions() const
+{
+  return m_positions;
+}
+
+/**
+ * @brief Returns the positions the features were detected at.
+ */
+const vector<Point2f>& FeatureTable::getSaved() const
+{
+  return m_saved;
+}
+
+/**
+ * @brief Returns the identifier the next feature added will get.
+ */
+size_t FeatureTable::getNextId() const
+{
+  return m_next_id;
+}
+
+/**
+ * @brief Counts the features older than an identifier.
+ *
+ * @param[in] id  The identifier, of a feature or not.
+ *
+ * @return The number of features with a lower identifier.
+ */
+size_t FeatureTable::countBefore(size_t id) const
+{
+  return lower_bound(m_ids.begin(), m_ids.end(), id) - m_ids.begin();
+}
+
+/**
+ * @brief Finds a feature by its identifier.
+ *
+ * @param[in] id  The identifier of the feature.
+ *
+ * @return The position of the feature in the arrays, -1 if it's been removed.
+ */
+int FeatureTable::find(size_t id) const
+{
+  vector<size_t>::const_iterator it = lower_bound(m_ids.begin(), m_ids.end(),
+                                                  id);
+
+  if (it == m_ids.end() || *it != id)
+    return -1;
+
+  return it - m_ids.begin();
+}
@@ -0,0 +1,59 @@
+/**
+ * @file feature_table.h
+ * @brief Header file for IStuff::FeatureTable.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef I_STUFF_FEATURE_TABLE_H__
+#define I_STUFF_FEATURE_TABLE_H__
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "opencv2/core/core.hpp"
+
+namespace IStuff
+{
+  class FeatureTable
+  {
+    /* Attributes */
+    private:
+      /**
+       * @brief One array per field, the same position in each being the same
+       *  feature. The identifiers are increasing.
+       */
+      std::vector<size_t> m_ids;
+      std::vector<cv::Point2f> m_positions,
+                               m_saved;
+
+      size_t m_next_id;
+
+      /* Methods */
+    public:
+      /* Constructors and Destructors */
+      FeatureTable();
+      virtual ~FeatureTable();
+
+      /* Setters */
+      void assign(const std::vector<cv::Point2f>&);
+      void add(cv::Point2f);
+      void setPositions(std::vector<cv::Point2f>&);
+      size_t compact(const std::vector<uchar>&,
+                     std::vector<cv::Point2f>* = NULL);
+      void clear();
+
+      /* Getters */
+      size_t size() const;
+      bool empty() const;
+      const std::vector<size_t>& getIds() const;
+      const std::vector<cv::Point2f>& getPositions() const;
+      const std::vector<cv::Point2f>& getSaved() const;
+      size_t getNextId() const;
+      size_t countBefore(size_t) const;
+      int find(size_t) const;
+  };
+}
+
+#endif /* defined I_STUFF_FEATURE_TABLE_H__ */
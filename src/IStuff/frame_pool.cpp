@@ -0,0 +1,133 @@
+/**
+ * @file frame_pool.cpp
+ * @class IStuff::FramePool
+ * @brief Class used to recycle the buffers of the frames.
+ * @details The pool keeps a reference to every buffer it allocates: when it's
+ *  the only one left, that is when every cv::Mat handed out has been released,
+ *  the buffer is handed out again to the next request of the same geometry.
+ *  OpenCV functions writing to a recycled buffer of the right geometry don't
+ *  allocate, so once every buffer needed is in the pool frames are processed
+ *  without allocations. Every user holding frames reserves room for them,
+ *  see reserve(); once the pool is full, buffers still in use aren't pooled
+ *  and are freed as usual.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#include "frame_pool.h"
+
+using namespace std;
+using namespace boost;
+using namespace cv;
+using namespace IStuff;
+
+const char FramePool::TAG[] = "Fpl";
+
+/* Constructors and Destructors */
+
+/**
+ * @brief Constructs an empty pool.
+ */
+FramePool::FramePool()
+  : m_capacity(DEFAULT_CAPACITY)
+{}
+
+FramePool::~FramePool()
+{}
+
+/**
+ * @brief Returns the pool shared by the whole program.
+ *
+ * @return The shared IStuff::FramePool.
+ */
+FramePool& FramePool::shared()
+{
+  static FramePool pool;
+
+  return pool;
+}
+
+/* Setters */
+
+/**
+ * @brief Makes room in the pool for more buffers.
+ * @details Called by every user holding frames, with the most frames it can
+ *  hold at once, so that they're all recycled instead of allocated again.
+ *
+ * @param[in] buffers  The number of buffers added to the capacity.
+ */
+void FramePool::reserve(size_t buffers)
+{
+  lock_guard<mutex> lock(m_mutex);
+
+  m_capacity += buffers;
+}
+
+/* Getters */
+
+/**
+ * @brief Returns how many buffers were handed out, and how many of them were
+ *  allocated.
+ *
+ * @return The counters of this pool.
+ */
+FramePoolStats FramePool::getStats()
+{
+  lock_guard<mutex> lock(m_mutex);
+
+  m_stats.pooled = m_buffers.size();
+
+  return m_stats;
+}
+
+/* Other methods */
+
+/**
+ * @brief Hands out a buffer of the given geometry.
+ * @details The content of a recycled buffer is the one of its last use.
+ *
+ * @param[in] size  The size of the buffer.
+ * @param[in] type  The type of the buffer elements.
+ *
+ * @return A buffer no one else is using, empty if the size is.
+ */
+Mat FramePool::acquire(Size size, int type)
+{
+  if (size.area() == 0)
+    return Mat();
+
+  lock_guard<mutex> lock(m_mutex);
+
+  m_stats.acquired++;
+
+  // NOTE: no new reference to a pooled buffer can be taken but from here,
+  // so a buffer referenced only by the pool stays free.
+  vector<Mat>::iterator free_buffer = m_buffers.end();
+
+  for (vector<Mat>::iterator it = m_buffers.begin(); it != m_buffers.end(); it++)
+    if (*it->refcount == 1)
+    {
+      if (it->size() == size && it->type() == type)
+      {
+        m_stats.recycled++;
+        return *it;
+      }
+
+      free_buffer = it;
+    }
+
+  if (debug)
+    cerr << TAG << ": Allocating a " << size.width << "x" << size.height
+      << " buffer.\n";
+
+  m_stats.allocated++;
+  Mat buffer(size, type);
+
+  // A full pool gives up a free buffer of another geometry, if any
+  if (m_buffers.size() < m_capacity)
+    m_buffers.push_back(buffer);
+  else if (free_buffer != m_buffers.end())
+    *free_buffer = buffer;
+
+  return buffer;
+}
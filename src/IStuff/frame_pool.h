@@ -0,0 +1,70 @@
+/**
+ * @file frame_pool.h
+ * @brief Header file for IStuff::FramePool.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef I_STUFF_FRAME_POOL_H__
+#define I_STUFF_FRAME_POOL_H__
+
+#include <iostream>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+#include "opencv2/core/core.hpp"
+
+extern bool debug;
+
+namespace IStuff
+{
+  /**
+   * @brief Counters of the buffers handed out by an IStuff::FramePool.
+   */
+  struct FramePoolStats
+  {
+    size_t acquired;
+    size_t recycled;
+    size_t allocated;
+    size_t pooled;
+
+    FramePoolStats()
+      : acquired(0), recycled(0), allocated(0), pooled(0)
+    {}
+  };
+
+  class FramePool
+  {
+    /* Attributes */
+    private:
+      const static char TAG[];
+      // Buffers pooled before any user reserves its own
+      const static size_t DEFAULT_CAPACITY = 8;
+
+      std::vector<cv::Mat> m_buffers;
+      size_t m_capacity;
+      boost::mutex m_mutex;
+
+      FramePoolStats m_stats;
+
+      /* Methods */
+    public:
+      /* Constructors and Destructors */
+      FramePool();
+      virtual ~FramePool();
+
+      static FramePool& shared();
+
+      /* Setters */
+      void reserve(size_t);
+
+      /* Getters */
+      FramePoolStats getStats();
+
+      /* Other methods */
+      cv::Mat acquire(cv::Size, int);
+  };
+}
+
+#endif /* defined I_STUFF_FRAME_POOL_H__ */
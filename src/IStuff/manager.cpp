@@ -22,9 +22,7 @@ const char Manager::TAG[] = "Mng";
  * @brief Constructs the class.
  */
 Manager::Manager()
-{
-  frames_tracked_count = RECOGNITION_PERIOD;
-}
+{}
 
 Manager::~Manager()
 {}
@@ -52,10 +50,59 @@ void Manager::setObject(const Object object)
  */
 void Manager::setDatabase(Database* database)
 {
-  frames_tracked_count = RECOGNITION_PERIOD;
+  scheduler.force();
   recognizer.setDatabase(database);
 }
 
+/**
+ * @brief Shares the recognition threads with other IStuff::Manager.
+ * @details Several streams can be elaborated at once, each by its own
+ *  IStuff::Manager and with the same IStuff::Database, without a thread per
+ *  stream waiting for recognitions.
+ *
+ * @param[in] pool  The IStuff::RecognitionPool, which must outlive this
+ *  IStuff::Manager.
+ */
+void Manager::setRecognitionPool(RecognitionPool* pool)
+{
+  recognizer.setPool(pool);
+}
+
+/**
+ * @brief Sets the frames tracked between two recognitions.
+ * @details Within these bounds, recognitions are done as soon as the tracking
+ *  degrades, see IStuff::RecognitionScheduler.
+ *
+ * @param[in] min_period  Frames tracked at least.
+ * @param[in] max_period  Frames tracked at most.
+ */
+void Manager::setRecognitionPeriods(int min_period, int max_period)
+{
+  scheduler.setPeriods(min_period, max_period);
+}
+
+/**
+ * @brief Sets how the IStuff::Tracker moves the labels, see
+ *  IStuff::Tracker::setMotionModel().
+ *
+ * @param[in] model  The IStuff::Tracker::MotionModel.
+ */
+void Manager::setMotionModel(Tracker::MotionModel model)
+{
+  tracker.setMotionModel(model);
+}
+
+/**
+ * @brief Sets whether the IStuff::Tracker validates the features by tracking
+ *  them back, see IStuff::Tracker::setForwardBackward().
+ *
+ * @param[in] enabled  `true` to check the features.
+ */
+void Manager::setForwardBackward(bool enabled)
+{
+  tracker.setForwardBackward(enabled);
+}
+
 /* Getters */
 
 /**
@@ -70,19 +117,37 @@ Object Manager::getObject()
   return actual_object;
 }
 
+/**
+ * @brief Returns the last frame the IStuff::Tracker painted for debugging.
+ *
+ * @return The painted frame, empty without debug.
+ */
+Mat Manager::getDebugImage()
+{
+  return tracker.getDebugImage();
+}
+
+/**
+ * @brief Returns how many recognitions were done, and why.
+ */
+SchedulerStats Manager::getSchedulerStats() const
+{
+  return scheduler.getStats();
+}
+
 /* Other methods */
 
 /**
  * @brief Elaborates a frame, searching for the IStuff::Object.
  * @details This function alternates the recognition to the tracking, making a
- *  new recognition every IStuff::Manager::RECOGNITION_PERIOD frames.
+ *  new recognition when the IStuff::RecognitionScheduler asks for it.
  *
  * @param frame  The frame to be analyzed.
  */
 void Manager::elaborateFrame(Mat frame)
 {
-  if ((getObject().empty() || frames_tracked_count >= RECOGNITION_PERIOD)
-      && !recognizer.isRunning())
+  if (!recognizer.isRunning() &&
+      scheduler.shouldRecognize(getObject().empty(), tracker.getQuality()))
   {
     if (hl_debug)
       cerr << TAG << ": Recognizing.\n";
@@ -92,10 +157,9 @@ void Manager::elaborateFrame(Mat frame)
   else
   {
     if (hl_debug)
-      cerr << TAG << ": Tracking " << frames_tracked_count << ".\n";
+      cerr << TAG << ": Tracking.\n";
 
-    if (frames_tracked_count < RECOGNITION_PERIOD)
-      frames_tracked_count++;
+    scheduler.frameTracked();
 
     setObject(tracker.trackFrame(frame));
   }
@@ -113,15 +177,27 @@ Mat Manager::paintObject(Mat frame)
   return getObject().paint(frame);
 }
 
+/**
+ * @brief Paints the various masks of the IStuff::Object on a copy of the frame.
+ *
+ * @param[in]  frame        The frame on which the IStuff::Object must be painted.
+ * @param[out] destination  The frame with the IStuff::Object painted on it, its
+ *  buffer is reused if it has the geometry of the frame.
+ */
+void Manager::paintObject(const Mat& frame, Mat& destination)
+{
+  getObject().paint(frame, destination);
+}
+
 /**
  * @brief Method to send messages to this IStuff::Manager.
  * @details Managed messages:<br />
  *  <dl>
  *    <dt>IStuff::Manager::MSG_RECOGNITION_START</dt>
  *    <dd>data: cv::Mat<br />
- *    This message is forwarded to both the IStuff::Recognizer (to make it
- *    start the recognization) and the IStuff::Tracker (to alert it).<br />
- *    This also resets the counter of frames tracked from last recognition.</dd>
+ *    This message is forwarded to both the IStuff::Tracker (to alert it)
+ *    and then the IStuff::Recognizer (to make it start the recognization),
+ *    so that the recognition never ends before the tracker knows of it.</dd>
  *    <dt>IStuff::Manager::MSG_RECOGNITION_END</dt>
  *    <dd>data: IStuff::Object<br />
  *    This message is forwarded to the IStuff::Tracker, to update its
@@ -137,10 +213,10 @@ void Manager::sendMessage(int msg, void* data, void* reply_to)
   switch (msg)
   {
     case MSG_RECOGNITION_START:
-      frames_tracked_count = 0;
-
-      recognizer.sendMessage(msg, data, this);
+      // The tracker starts recording before the recognition can end and
+      // replay: start() of its IStuff::FakableQueue must not overlap discard()
       tracker.sendMessage(msg, data);
+      recognizer.sendMessage(msg, data, this);
       break;
 
     case MSG_RECOGNITION_END:
@@ -157,7 +233,7 @@ void Manager::sendMessage(int msg, void* data, void* reply_to)
     case MSG_TRACKING_END:
       // Syncrhonized
       {
-        shared_lock<shared_mutex> lock(object_update);
+        unique_lock<shared_mutex> lock(object_update);
 
         actual_object = *(Object*)data;
       }
@@ -19,6 +19,7 @@
 #include "database.h"
 #include "recognizer.h"
 #include "tracker.h"
+#include "recognition_scheduler.h"
 
 extern bool debug,
             hl_debug;
@@ -36,17 +37,18 @@ namespace IStuff
 
     private:
       const static char TAG[];
-      const static int RECOGNITION_PERIOD = 30;
 
       /**
-       * @brief When this reaches RECOGNITION_PERIOD, a new recognition is done.
+       * @brief Decides, from how the tracking goes, when a new recognition is done.
        */
-      int frames_tracked_count;
+      RecognitionScheduler scheduler;
       boost::shared_mutex object_update;
 
       Object actual_object;
-      Recognizer recognizer;
+      // NOTE: the recognizer is destroyed, waiting for its last recognition,
+      // before the tracker it informs.
       Tracker tracker;
+      Recognizer recognizer;
 
       /* Methods */
     public:
@@ -56,13 +58,20 @@ namespace IStuff
 
       /* Setters */
       void setDatabase(Database*);
+      void setRecognitionPool(RecognitionPool*);
+      void setRecognitionPeriods(int, int);
+      void setMotionModel(Tracker::MotionModel);
+      void setForwardBackward(bool);
 
       /* Getters */
       Object getObject();
+      SchedulerStats getSchedulerStats() const;
+      cv::Mat getDebugImage();
 
       /* Other methods */
       void elaborateFrame(cv::Mat);
       cv::Mat paintObject(cv::Mat);
+      void paintObject(const cv::Mat&, cv::Mat&);
 
       void sendMessage(int, void*, void* = NULL);
 
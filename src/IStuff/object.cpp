@@ -80,18 +80,33 @@ Mat Object::paint(Mat frame)
 	if (labels.empty())
 		return frame;
 
-	int vertCount = 1;
+	Mat result;
+	paint(frame, result);
+
+	return result;
+}
+
+/**
+ * @brief Paints the various IStuff::Label of the IStuff::Object on a copy of the frame.
+ * @details The copy is written in the destination, whose buffer is reused if it
+ *  has the geometry of the frame: no allocation occurs. If the destination is
+ *  the frame itself, the IStuff::Object is painted in place.
+ *
+ * @param[in]  frame        The frame on which the IStuff::Object must be painted.
+ * @param[out] destination  The frame with the IStuff::Object painted on it.
+ */
+void Object::paint(const Mat& frame, Mat& destination) const
+{
+	if (destination.data != frame.data)
+		frame.copyTo(destination);
 
-	Mat result = frame.clone();
 	for(Label a_label : labels)
 	{
-		circle( result, a_label.position, 5, a_label.color, 1 );
+		circle( destination, a_label.position, 5, a_label.color, 1 );
 
-		putText( result, a_label.name,
+		putText( destination, a_label.name,
 						 Point2f( a_label.position.x + 10, a_label.position.y + 10 ),
 						 FONT_HERSHEY_DUPLEX, 2, a_label.color, 3 );
 	}
-
-	return result;
 }
 
@@ -61,6 +61,7 @@ namespace IStuff
 
 			/* Other methods */
 			cv::Mat paint(cv::Mat);
+			void paint(const cv::Mat&, cv::Mat&) const;
 	};
 }
 
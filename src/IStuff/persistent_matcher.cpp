@@ -0,0 +1,87 @@
+/**
+ * @file	persistent_matcher.cpp
+ * @brief	Definition for PersistentFlannMatcher class
+ * @class	IStuff::PersistentFlannMatcher
+ * @details	A cv::FlannBasedMatcher whose trained index can be written to a
+ * 			file and read back, instead of being rebuilt at every start.
+ * 			The index file doesn't contain the descriptors: they must be
+ * 			added, in the same order, before loading it
+ * @version	0.1.0
+ * @date	2026-10-16
+ */
+
+#include "persistent_matcher.h"
+
+using namespace std;
+using namespace cv;
+using namespace IStuff;
+
+/**
+ * @brief	Constructor
+ * @param[in] _indexParams	The parameters of the FLANN index
+ * @param[in] _searchParams	The parameters of the FLANN searches
+ */
+PersistentFlannMatcher::PersistentFlannMatcher( const Ptr< flann::IndexParams >& _indexParams, const Ptr< flann::SearchParams >& _searchParams ) :
+	FlannBasedMatcher( _indexParams, _searchParams )
+{
+
+}
+
+/**
+ * @brief	Destructor
+ */
+PersistentFlannMatcher::~PersistentFlannMatcher() {
+
+}
+
+/**
+ * @brief	Writes the trained index to a file
+ * @param[in] fileName	The file to be written
+ * @retval	false if the matcher isn't trained yet
+ */
+bool PersistentFlannMatcher::saveIndex( const string& fileName ) const {
+	if( flannIndex.empty() )
+		return false;
+
+	flannIndex -> save( fileName );
+
+	return true;
+}
+
+/**
+ * @brief	Reads a trained index from a file, in place of training
+ * @details	On success the matcher is trained and a following train() does
+ * 			nothing, unless other descriptors are added
+ * @param[in] fileName	The file written by saveIndex()
+ * @retval	false if no descriptors were added or the file can't be read,
+ * 			in which case the matcher is left untrained
+ */
+bool PersistentFlannMatcher::loadIndex( const string& fileName ) {
+	if( trainDescCollection.empty() )
+		return false;
+
+	mergedDescriptors.set( trainDescCollection );
+	flannIndex = new flann::Index();
+
+	if( !flannIndex -> load( mergedDescriptors.getDescriptors(), fileName ) ) {
+		flannIndex.release();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Clones the matcher
+ * @details	Like for cv::FlannBasedMatcher the index can't be copied, the
+ * 			clone holds the same descriptors but needs to be trained
+ * @param[in] emptyTrainData	Whether the descriptors are to be left out
+ */
+Ptr< DescriptorMatcher > PersistentFlannMatcher::clone( bool emptyTrainData ) const {
+	PersistentFlannMatcher* matcher = new PersistentFlannMatcher( indexParams, searchParams );
+
+	if( !emptyTrainData )
+		matcher -> add( trainDescCollection );
+
+	return matcher;
+}
@@ -0,0 +1,32 @@
+/**
+* @file persistent_matcher.h
+* @brief Library for PersistentFlannMatcher class
+* @version 0.1.0
+* @date 2026-10-16
+*/
+
+#ifndef PERSISTENT_MATCHER_H__
+#define PERSISTENT_MATCHER_H__
+
+// Standard C++ libraries
+#include <string>
+
+// OpenCV libraries
+#include "opencv2/core/core.hpp"
+#include "opencv2/features2d/features2d.hpp"
+#include "opencv2/flann/flann.hpp"
+
+namespace IStuff {
+	class PersistentFlannMatcher: public cv::FlannBasedMatcher {
+		public:
+			PersistentFlannMatcher( const cv::Ptr< cv::flann::IndexParams >&, const cv::Ptr< cv::flann::SearchParams >& );
+			virtual ~PersistentFlannMatcher();
+
+			bool saveIndex( const std::string& ) const;
+			bool loadIndex( const std::string& );
+
+			virtual cv::Ptr< cv::DescriptorMatcher > clone( bool emptyTrainData = false ) const;
+	};
+};
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file point_index.cpp
+ * @class IStuff::PointIndex
+ * @brief Class used to find the points nearest to a position.
+ * @details Made for the few hundreds of features tracked by IStuff::Tracker:
+ *  the distances to every point are computed four at a time, with SSE2 where
+ *  available, from coordinates stored one axis per array; the nearest points
+ *  are then selected in linear time. For so few points this is faster than
+ *  building any tree, and the result is exact.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#include "point_index.h"
+
+using namespace std;
+using namespace cv;
+using namespace IStuff;
+
+/* Constructors and Destructors */
+
+PointIndex::PointIndex()
+  : m_size(0)
+{}
+
+PointIndex::~PointIndex()
+{}
+
+/* Setters */
+
+/**
+ * @brief Replaces the points searched.
+ *
+ * @param[in] points  The points, found by their position in this vector.
+ */
+void PointIndex::build(const vector<Point2f>& points)
+{
+  m_size = points.size();
+
+  // The padding is never selected, it only keeps the distances finite
+  size_t padded = (m_size + LANES - 1) / LANES * LANES;
+  m_xs.assign(padded, 1e18f);
+  m_ys.assign(padded, 1e18f);
+
+  for (size_t i = 0; i < m_size; i++)
+  {
+    m_xs[i] = points[i].x;
+    m_ys[i] = points[i].y;
+  }
+}
+
+/* Getters */
+
+/**
+ * @brief Returns the number of points searched.
+ */
+size_t PointIndex::size() const
+{
+  return m_size;
+}
+
+/* Other methods */
+
+/**
+ * @brief Finds the points nearest to a position.
+ *
+ * @param[in]  position  The position searched.
+ * @param[in]  count     The number of points wanted; fewer are found if there
+ *  are fewer points.
+ * @param[out] indices   The positions of the nearest points, in no order.
+ */
+void PointIndex::nearest(Point2f position, size_t count, vector<int>& indices)
+{
+  count = min(count, m_size);
+  indices.clear();
+
+  if (count == 0)
+    return;
+
+  distances(position);
+
+  m_order.resize(m_size);
+  for (size_t i = 0; i < m_size; i++)
+    m_order[i] = i;
+
+  const vector<float>& distance = m_distances;
+  nth_element(m_order.begin(), m_order.begin() + (count - 1), m_order.end(),
+              [&distance](int a, int b)
+              {
+                return distance[a] < distance[b];
+              });
+
+  indices.assign(m_order.begin(), m_order.begin() + count);
+}
+
+/**
+ * @brief Computes the squared distances from a position to every point.
+ */
+void PointIndex::distances(Point2f position)
+{
+  size_t padded = m_xs.size();
+  m_distances.resize(padded);
+
+  const float* xs = &m_xs[0];
+  const float* ys = &m_ys[0];
+  float* result = &m_distances[0];
+
+#ifdef __SSE2__
+  __m128 x = _mm_set1_ps(position.x),
+         y = _mm_set1_ps(position.y);
+
+  for (size_t i = 0; i < padded; i += LANES)
+  {
+    __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), x),
+           dy = _mm_sub_ps(_mm_loadu_ps(ys + i), y);
+
+    _mm_storeu_ps(result + i, _mm_add_ps(_mm_mul_ps(dx, dx),
+                                         _mm_mul_ps(dy, dy)));
+  }
+#else
+  for (size_t i = 0; i < padded; i++)
+  {
+    float dx = xs[i] - position.x,
+          dy = ys[i] - position.y;
+
+    result[i] = dx * dx + dy * dy;
+  }
+#endif
+}
@@ -0,0 +1,60 @@
+/**
+ * @file point_index.h
+ * @brief Header file for IStuff::PointIndex.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef I_STUFF_POINT_INDEX_H__
+#define I_STUFF_POINT_INDEX_H__
+
+#include <vector>
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "opencv2/core/core.hpp"
+
+namespace IStuff
+{
+  class PointIndex
+  {
+    /* Attributes */
+    private:
+      /**
+       * @brief Coordinates of the points, one array per axis, padded to a
+       *  multiple of LANES.
+       */
+      std::vector<float> m_xs,
+                         m_ys;
+      size_t m_size;
+
+      // Scratch buffers of the searches
+      std::vector<float> m_distances;
+      std::vector<int> m_order;
+
+      const static size_t LANES = 4;
+
+      /* Methods */
+    public:
+      /* Constructors and Destructors */
+      PointIndex();
+      virtual ~PointIndex();
+
+      /* Setters */
+      void build(const std::vector<cv::Point2f>&);
+
+      /* Getters */
+      size_t size() const;
+
+      /* Other methods */
+      void nearest(cv::Point2f, size_t, std::vector<int>&);
+
+    private:
+      void distances(cv::Point2f);
+  };
+}
+
+#endif /* defined I_STUFF_POINT_INDEX_H__ */
@@ -0,0 +1,231 @@
+/**
+ * @file recognition_pool.cpp
+ * @class IStuff::RecognitionPool
+ * @brief Class used to share recognition threads among several streams.
+ * @details Each stream, registered with addStream(), can have one recognition
+ *  waiting or running at a time, as an IStuff::Recognizer does on its own
+ *  IStuff::Worker. Free threads take the waiting requests round robin,
+ *  starting from the stream after the last one served: a stream asking for
+ *  recognitions more often than others can't starve them.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#include "recognition_pool.h"
+
+using namespace std;
+using namespace IStuff;
+
+const char RecognitionPool::TAG[] = "RPool";
+
+// Set on the threads running RecognitionPool::run()
+static thread_local bool pool_thread = false;
+
+/* Constructors and Destructors */
+
+/**
+ * @brief Constructs the pool and starts its threads.
+ *
+ * @param[in] threads  The number of threads, 0 for one per core.
+ */
+RecognitionPool::RecognitionPool(size_t threads)
+  : m_next(0), m_closed(false)
+{
+  if (threads == 0)
+    threads = max(boost::thread::hardware_concurrency(), 1u);
+
+  // Started last, when everything they use is constructed
+  for (size_t i = 0; i < threads; i++)
+    m_threads.create_thread(boost::bind(&RecognitionPool::run, this));
+}
+
+/**
+ * @brief Runs the requests still waiting, then stops the threads.
+ */
+RecognitionPool::~RecognitionPool()
+{
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_closed = true;
+  }
+
+  m_work.notify_all();
+  m_threads.join_all();
+}
+
+/* Getters */
+
+/**
+ * @brief Checks whether a recognition of a stream is waiting or running.
+ *
+ * @param[in] stream  The stream, as returned by addStream().
+ */
+bool RecognitionPool::isBusy(size_t stream) const
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+
+  return m_streams[stream].pending || m_streams[stream].running;
+}
+
+/**
+ * @brief Checks whether the calling thread is one of the threads of a pool.
+ * @details Work run by a pool shouldn't start parallel work of its own: the
+ *  other threads of the pool already keep the cores busy.
+ *
+ * @return `true` inside a task of any IStuff::RecognitionPool.
+ */
+bool RecognitionPool::isPoolThread()
+{
+  return pool_thread;
+}
+
+/**
+ * @brief Returns the number of threads of the pool.
+ */
+size_t RecognitionPool::getThreads() const
+{
+  return m_threads.size();
+}
+
+/**
+ * @brief Returns how many recognitions of a stream have been run.
+ *
+ * @param[in] stream  The stream, as returned by addStream().
+ */
+size_t RecognitionPool::getServed(size_t stream) const
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+
+  return m_streams[stream].served;
+}
+
+/* Other methods */
+
+/**
+ * @brief Registers a new stream.
+ *
+ * @return The identifier of the stream, used in the other calls.
+ */
+size_t RecognitionPool::addStream()
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+
+  m_streams.push_back(Stream());
+
+  if (debug)
+    cerr << TAG << ": stream " << m_streams.size() - 1 << " added.\n";
+
+  return m_streams.size() - 1;
+}
+
+/**
+ * @brief Unregisters a stream: its waiting request is dropped and the running
+ *  one, if any, is waited for.
+ * @details Afterwards nothing submitted by the stream is referenced by the
+ *  pool, so what its tasks use can be destroyed.
+ *
+ * @param[in] stream  The stream, as returned by addStream().
+ */
+void RecognitionPool::removeStream(size_t stream)
+{
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  Stream& a_stream = m_streams[stream];
+
+  a_stream.removed = true;
+  a_stream.pending = false;
+  a_stream.task = Task();
+
+  while (a_stream.running)
+    m_done.wait(lock);
+
+  if (debug)
+    cerr << TAG << ": stream " << stream << " removed.\n";
+}
+
+/**
+ * @brief Submits the recognition of a stream, without waiting.
+ *
+ * @param[in] stream  The stream, as returned by addStream().
+ * @param[in] task    The recognition to be run.
+ *
+ * @return `false` if the stream has a recognition waiting or running already.
+ */
+bool RecognitionPool::submit(size_t stream, const Task& task)
+{
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    Stream& a_stream = m_streams[stream];
+
+    if (m_closed || a_stream.removed || a_stream.pending || a_stream.running)
+      return false;
+
+    a_stream.task = task;
+    a_stream.pending = true;
+  }
+
+  m_work.notify_one();
+
+  return true;
+}
+
+/**
+ * @brief Body of the threads: runs the requests, one stream after the other.
+ */
+void RecognitionPool::run()
+{
+  pool_thread = true;
+
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+
+  while (true)
+  {
+    // The first stream with a waiting request, from m_next on
+    size_t chosen = m_streams.size();
+    for (size_t i = 0; i < m_streams.size(); i++)
+    {
+      size_t a_stream = (m_next + i) % m_streams.size();
+
+      if (m_streams[a_stream].pending)
+      {
+        chosen = a_stream;
+        break;
+      }
+    }
+
+    if (chosen == m_streams.size())
+    {
+      if (m_closed)
+        break;
+
+      m_work.wait(lock);
+      continue;
+    }
+
+    m_next = (chosen + 1) % m_streams.size();
+
+    Task a_task;
+    a_task.swap(m_streams[chosen].task);
+    m_streams[chosen].pending = false;
+    m_streams[chosen].running = true;
+
+    lock.unlock();
+
+    try
+    {
+      a_task();
+    }
+    catch (std::exception& e)
+    {
+      cerr << TAG << ": Recognition failed: " << e.what() << endl;
+    }
+
+    // Release what the task holds, frames included, before taking another
+    a_task = Task();
+
+    lock.lock();
+
+    m_streams[chosen].running = false;
+    m_streams[chosen].served++;
+    m_done.notify_all();
+  }
+}
@@ -0,0 +1,85 @@
+/**
+ * @file recognition_pool.h
+ * @brief Header file for IStuff::RecognitionPool.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef I_STUFF_RECOGNITION_POOL_H__
+#define I_STUFF_RECOGNITION_POOL_H__
+
+#include <iostream>
+#include <vector>
+#include <exception>
+
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+
+extern bool debug;
+
+namespace IStuff
+{
+  class RecognitionPool
+  {
+    /* Attributes */
+    public:
+      /**
+       * @brief A recognition, run by one of the threads of the pool.
+       */
+      typedef boost::function<void ()> Task;
+
+    private:
+      /**
+       * @brief The recognition requests of a stream, at most one at a time.
+       */
+      struct Stream
+      {
+        Task task;
+        bool pending,
+             running,
+             removed;
+        size_t served;
+
+        Stream()
+          : pending(false), running(false), removed(false), served(0)
+        {}
+      };
+
+      const static char TAG[];
+
+      mutable boost::mutex m_mutex;
+      boost::condition_variable m_work,
+                                m_done;
+
+      std::vector<Stream> m_streams;
+      /**
+       * @brief The stream whose request is looked at first.
+       */
+      size_t m_next;
+      bool m_closed;
+
+      boost::thread_group m_threads;
+
+      /* Methods */
+    public:
+      /* Constructors and Destructors */
+      RecognitionPool(size_t = 0);
+      virtual ~RecognitionPool();
+
+      /* Getters */
+      bool isBusy(size_t) const;
+      size_t getThreads() const;
+      size_t getServed(size_t) const;
+      static bool isPoolThread();
+
+      /* Other methods */
+      size_t addStream();
+      void removeStream(size_t);
+      bool submit(size_t, const Task&);
+
+    private:
+      void run();
+  };
+}
+
+#endif /* defined I_STUFF_RECOGNITION_POOL_H__ */
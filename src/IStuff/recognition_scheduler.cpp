@@ -0,0 +1,138 @@
+/**
+ * @file recognition_scheduler.cpp
+ * @class IStuff::RecognitionScheduler
+ * @brief Class used to decide when the IStuff::Manager recognizes a frame.
+ * @details The tracking is trusted as long as it's good: a recognition starts
+ *  early, after at least the minimum period, when too many features are lost,
+ *  when the optical flow error grows or when the labels spread or shrink, as
+ *  they do when the tracked features slide off the object; otherwise it's put
+ *  off until the maximum period.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#include "recognition_scheduler.h"
+
+using namespace std;
+using namespace IStuff;
+
+const char RecognitionScheduler::TAG[] = "RSch";
+
+/* Constructors and Destructors */
+
+RecognitionScheduler::RecognitionScheduler()
+  : m_min_period(DEFAULT_MIN_PERIOD), m_max_period(DEFAULT_MAX_PERIOD),
+    m_frames(0), m_forced(true)
+{}
+
+RecognitionScheduler::~RecognitionScheduler()
+{}
+
+/* Setters */
+
+/**
+ * @brief Sets the frames between two recognitions.
+ *
+ * @param[in] min_period  Frames tracked at least, however bad the tracking.
+ * @param[in] max_period  Frames tracked at most, however good the tracking;
+ *  equal to the minimum for a fixed period.
+ */
+void RecognitionScheduler::setPeriods(int min_period, int max_period)
+{
+  m_min_period = max(min_period, 1);
+  m_max_period = max(max_period, m_min_period);
+}
+
+/* Getters */
+
+/**
+ * @brief Returns the frames tracked at least between two recognitions.
+ */
+int RecognitionScheduler::getMinPeriod() const
+{
+  return m_min_period;
+}
+
+/**
+ * @brief Returns the frames tracked at most between two recognitions.
+ */
+int RecognitionScheduler::getMaxPeriod() const
+{
+  return m_max_period;
+}
+
+/**
+ * @brief Returns the decisions taken so far.
+ */
+SchedulerStats RecognitionScheduler::getStats() const
+{
+  return m_stats;
+}
+
+/* Other methods */
+
+/**
+ * @brief Decides whether the current frame must be recognized.
+ * @details Called for the frames that can be recognized, that is while no
+ *  recognition is running; a `true` means the recognition starts.
+ *
+ * @param[in] empty    Whether there's no IStuff::Object to track.
+ * @param[in] quality  How the tracking of the last frame went.
+ *
+ * @return `true` if the frame must be recognized, `false` if tracked.
+ */
+bool RecognitionScheduler::shouldRecognize(bool empty,
+                                           const TrackingQuality& quality)
+{
+  size_t* reason = NULL;
+
+  if (m_forced || empty)
+    reason = &m_stats.forced;
+  else if (m_frames >= m_max_period)
+    reason = &m_stats.periodic;
+  else if (m_frames >= m_min_period)
+  {
+    float survivors = quality.reference_features > 0 ?
+      (float) quality.features / quality.reference_features : 0;
+
+    if (survivors < MIN_SURVIVORS)
+      reason = &m_stats.lost_features;
+    else if (quality.error > MAX_ERROR)
+      reason = &m_stats.high_error;
+    else if (quality.spread > 0 &&
+             fabs(log(quality.spread)) > log(1 + MAX_SPREAD_CHANGE))
+      reason = &m_stats.spread;
+    else
+      m_stats.deferred++;
+  }
+
+  if (!reason)
+    return false;
+
+  if (debug)
+    cerr << TAG << ": Recognizing after " << m_frames << " frames.\n";
+
+  (*reason)++;
+  m_stats.recognitions++;
+  m_frames = 0;
+  m_forced = false;
+
+  return true;
+}
+
+/**
+ * @brief Counts a frame tracked, whether a recognition is running or not.
+ */
+void RecognitionScheduler::frameTracked()
+{
+  m_stats.tracked++;
+  m_frames++;
+}
+
+/**
+ * @brief Makes the next frame be recognized, whatever the tracking.
+ */
+void RecognitionScheduler::force()
+{
+  m_forced = true;
+}
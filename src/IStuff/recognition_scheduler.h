@@ -0,0 +1,112 @@
+/**
+ * @file recognition_scheduler.h
+ * @brief Header file for IStuff::RecognitionScheduler.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef I_STUFF_RECOGNITION_SCHEDULER_H__
+#define I_STUFF_RECOGNITION_SCHEDULER_H__
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+extern bool debug;
+
+namespace IStuff
+{
+  /**
+   * @brief How well the IStuff::Tracker is following the IStuff::Object.
+   */
+  struct TrackingQuality
+  {
+    // Features tracked in the last frame among the ones detected when the
+    // last recognition started, and how many these were
+    size_t features,
+           reference_features;
+    // Features detected since, to replace the lost ones, tracked in the last
+    // frame: they don't count as tracked
+    size_t replenished;
+    // Mean error of the optical flow of the features in the last frame
+    float error;
+    // Spread of the labels around their center, relative to the one they
+    // had when last recognized
+    float spread;
+
+    TrackingQuality()
+      : features(0), reference_features(0), replenished(0), error(0),
+        spread(1)
+    {}
+  };
+
+  /**
+   * @brief The decisions of an IStuff::RecognitionScheduler.
+   */
+  struct SchedulerStats
+  {
+    size_t tracked,
+           recognitions,
+           // Recognitions started for each reason
+           forced,
+           periodic,
+           lost_features,
+           high_error,
+           spread,
+           // Frames between the minimum and the maximum period tracked
+           // without recognizing, the tracking being good
+           deferred;
+
+    SchedulerStats()
+      : tracked(0), recognitions(0), forced(0), periodic(0),
+        lost_features(0), high_error(0), spread(0), deferred(0)
+    {}
+  };
+
+  class RecognitionScheduler
+  {
+    /* Attributes */
+    private:
+      const static char TAG[];
+
+      const static int DEFAULT_MIN_PERIOD = 10;
+      const static int DEFAULT_MAX_PERIOD = 120;
+      // Under this fraction of features tracked, the tracking is degrading
+      const static float constexpr MIN_SURVIVORS = .5;
+      const static float constexpr MAX_ERROR = 20;
+      // Largest change of the label spread, in either direction
+      const static float constexpr MAX_SPREAD_CHANGE = .25;
+
+      int m_min_period,
+          m_max_period;
+
+      /**
+       * @brief Frames elaborated since the last recognition started.
+       */
+      int m_frames;
+      bool m_forced;
+
+      SchedulerStats m_stats;
+
+      /* Methods */
+    public:
+      /* Constructors and Destructors */
+      RecognitionScheduler();
+      virtual ~RecognitionScheduler();
+
+      /* Setters */
+      void setPeriods(int, int);
+
+      /* Getters */
+      int getMinPeriod() const;
+      int getMaxPeriod() const;
+      SchedulerStats getStats() const;
+
+      /* Other methods */
+      bool shouldRecognize(bool, const TrackingQuality&);
+      void frameTracked();
+      void force();
+  };
+}
+
+#endif /* defined I_STUFF_RECOGNITION_SCHEDULER_H__ */
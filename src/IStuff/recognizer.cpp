@@ -25,16 +25,20 @@ const char Recognizer::TAG[] = "Rec";
  * @brief Constructs a structure used to find 3D objects inside a video stream.
  */
 Recognizer::Recognizer()
+  : m_pool(NULL), m_stream(0)
 {
-  //m_thread = auto_ptr<thread>(new thread());
-  setRunning(false);
-
   if (debug)
     cerr << TAG << " constructed.\n";
 }
 
+/**
+ * @brief Waits for the recognition running in the IStuff::RecognitionPool, if
+ *  any, since it informs the IStuff::Manager of this IStuff::Recognizer.
+ */
 Recognizer::~Recognizer()
-{}
+{
+  setPool(NULL);
+}
 
 /* Setters */
 
@@ -48,21 +52,38 @@ void Recognizer::setDatabase(Database* matcher)
   m_matcher = matcher;
 }
 
-void Recognizer::setRunning(bool running)
+/**
+ * @brief Makes this IStuff::Recognizer run its recognitions on threads shared
+ *  with other streams, instead of its own.
+ * @details Must not be called while recognizing.
+ *
+ * @param[in] pool  The IStuff::RecognitionPool, `NULL` to go back to the own
+ *  thread. It must outlive this IStuff::Recognizer.
+ */
+void Recognizer::setPool(RecognitionPool* pool)
 {
-  m_running = running;
+  if (m_pool)
+    m_pool->removeStream(m_stream);
+
+  m_pool = pool;
+
+  if (m_pool)
+    m_stream = m_pool->addStream();
 }
 
 /* Getters */
 
 /**
- * @brief Checks whether this IStuff::Recognizer has a thread up and running.
+ * @brief Checks whether this IStuff::Recognizer is recognizing in background.
  *
  * @return `true` if recognizing, `false` otherwise.
  */
 bool Recognizer::isRunning() const
 {
-  return m_running;
+  if (m_pool)
+    return m_pool->isBusy(m_stream);
+
+  return m_worker.isBusy();
 }
 
 /* Other methods */
@@ -79,7 +100,13 @@ Object Recognizer::recognizeFrame(Mat frame)
   if (debug)
     cerr << TAG << ": Recognizing frame.\n";
 
-  Object result = m_matcher->match(frame.clone());
+  // Every object found is tracked, their labels are merged into a single one.
+  // NOTE: the frame isn't copied, it's a pooled buffer which isn't recycled
+  // as long as it's referenced here.
+  Object result;
+  for (Object an_object : m_matcher->matchAll(frame))
+    for (Label a_label : an_object.getLabels())
+      result.addLabel(a_label);
 
   if (debug)
     cerr << TAG << ": Frame recognized.\n";
@@ -89,11 +116,14 @@ Object Recognizer::recognizeFrame(Mat frame)
 
 /**
  * @brief Method to do the recognization process in a separate thread.
+ * @details The recognition is run by the IStuff::RecognitionPool, if set, or
+ *  by the IStuff::Worker of this IStuff::Recognizer; either is busy as soon as
+ *  this returns.
  *
  * @param[in] frame      The frame to be searched for an IStuff::Object.
  * @param[in] reference  The reference to the IStuff::Manager to inform of the result.
  *
- * @return `true` if the thread is started, `false` if it was already running.
+ * @return `true` if the recognition is started, `false` if one was already running.
  */
 bool Recognizer::backgroundRecognizeFrame(Mat frame, Manager* reference)
 {
@@ -109,17 +139,16 @@ bool Recognizer::backgroundRecognizeFrame(Mat frame, Manager* reference)
     cerr << TAG << ": Starting in background.\n";
 
   // NOTE: "[=]" means "all used variables are captured in the lambda".
-  m_thread = auto_ptr<thread>(new thread([=]()
+  Worker::Task recognition = [=]()
   {
-    setRunning(true);
-
     Object new_object = recognizeFrame(frame);
     reference->sendMessage(Manager::MSG_RECOGNITION_END, &new_object);
+  };
 
-    setRunning(false);
-  }));
+  if (m_pool)
+    return m_pool->submit(m_stream, recognition);
 
-  return true;
+  return m_worker.submit(recognition);
 }
 
 /**
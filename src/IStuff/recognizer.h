@@ -18,6 +18,8 @@
 
 #include "object.h"
 #include "database.h"
+#include "worker.h"
+#include "recognition_pool.h"
 
 extern bool debug;
 
@@ -31,11 +33,21 @@ namespace IStuff
     private:
       const static char TAG[];
 
-      std::auto_ptr<boost::thread> m_thread;
-      bool m_running;
-
       Database* m_matcher;
 
+      /**
+       * @brief The threads shared with other streams, if any, and the stream
+       *  of this IStuff::Recognizer among them.
+       */
+      RecognitionPool* m_pool;
+      size_t m_stream;
+
+      /**
+       * @brief The thread recognizing in background, at most one frame at a
+       *  time, when there's no IStuff::RecognitionPool.
+       */
+      Worker m_worker;
+
       /* Methods */
     public:
       /* Constructors and Destructors */
@@ -44,6 +56,7 @@ namespace IStuff
 
       /* Setters */
       void setDatabase(Database*);
+      void setPool(RecognitionPool*);
 
       /* Getters */
       bool isRunning() const;
@@ -53,10 +66,6 @@ namespace IStuff
       bool backgroundRecognizeFrame(cv::Mat, Manager*);
 
       void sendMessage(int, void*, void* = NULL);
-
-    private:
-      /* Setters */
-      void setRunning(bool);
   };
 }
 
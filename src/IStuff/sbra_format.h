@@ -0,0 +1,84 @@
+/**
+* @file sbra_format.h
+* @brief Layout of the single file database format
+* @details A database is stored in database/<name>.sbra as follows:
+* 		- a Header, holding the backend and the position of the sample table;
+* 		- the descriptor blocks, one for every sample, each aligned to ALIGNMENT
+* 		  bytes so that they can be used in place once the file is mapped;
+* 		- the KeypointRecord of every sample;
+* 		- the strings area, holding the name of every sample followed by
+* 		  the names of its labels;
+* 		- the LabelRecord of every sample;
+* 		- the sample table, one SampleEntry for every sample.
+* 		All offsets are in bytes from the start of the file, all values are
+* 		stored in the native byte order.
+* 		Version 2 added the FLANN parameters at the end of the Header; the
+* 		trained index is kept aside, in database/<name>.<checksum>.flann.
+* @version 0.1.0
+* @date 2026-10-16
+*/
+
+#ifndef SBRA_FORMAT_H__
+#define SBRA_FORMAT_H__
+
+#include <stdint.h>
+
+namespace IStuff {
+	namespace Sbra {
+		const char MAGIC[ 8 ] = { 'S', 'B', 'R', 'A', 'D', 'B', '\r', '\n' };
+		const uint32_t VERSION = 2;
+		const uint32_t ALIGNMENT = 64;
+
+		// Marker of the files written before the single file format
+		const char LEGACY_MAGIC[] = "SBRA!";
+
+		struct Header {
+			char magic[ 8 ];
+			uint32_t version;
+			uint32_t sampleCount;
+			char features[ 16 ];
+			char matcher[ 16 ];
+			uint64_t sampleTableOffset;
+			uint64_t fileSize;
+			// Since version 2
+			uint32_t trees;
+			uint32_t checks;
+		};
+
+		// Size of the Header of the version 1 files
+		const size_t HEADER_V1_SIZE = 64;
+
+		struct SampleEntry {
+			uint64_t nameOffset;
+			uint64_t labelsOffset;
+			uint64_t keypointsOffset;
+			uint64_t descriptorsOffset;
+			uint32_t nameLength;
+			uint32_t labelCount;
+			uint32_t keypointCount;
+			int32_t descriptorRows;
+			int32_t descriptorCols;
+			int32_t descriptorType;
+		};
+
+		struct KeypointRecord {
+			float x;
+			float y;
+			float size;
+			float angle;
+			float response;
+			int32_t octave;
+			int32_t classId;
+		};
+
+		struct LabelRecord {
+			float x;
+			float y;
+			uint64_t nameOffset;
+			uint32_t nameLength;
+			uint32_t reserved;
+		};
+	};
+};
+
+#endif
@@ -1,13 +1,31 @@
 /**
 * @file serialize_opencv.h
 * @brief Serialization support for various opencv classes thought boost
+* @details Matrices are written as a single binary array when continuous and
+* 		row by row otherwise; in both cases the stream holds only the
+* 		elements, without the padding given by the step, so the format is the
+* 		same of the former element by element serialization.
+* 		cv::Point2f and cv::KeyPoint are marked as bitwise serializable, so
+* 		that vectors of them are written as a single binary array by the
+* 		binary archives.
 * @author Mattia Rizzini
-* @version 0.1.1
+* @version 0.2.0
 * @date 2013-07-15
 */
+
+#ifndef SERIALIZE_OPENCV_H__
+#define SERIALIZE_OPENCV_H__
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/features2d/features2d.hpp"
+
 #include "boost/serialization/serialization.hpp"
 #include "boost/serialization/split_free.hpp"
 #include "boost/serialization/vector.hpp"
+#include "boost/serialization/array.hpp"
+#include "boost/serialization/is_bitwise_serializable.hpp"
+#include "boost/serialization/level.hpp"
+#include "boost/serialization/tracking.hpp"
 
 BOOST_SERIALIZATION_SPLIT_FREE( cv::Mat )
 namespace boost {
@@ -22,10 +40,13 @@ namespace boost {
 			ar & m.rows;
 			ar & elemSize;
 			ar & elemType;
-			size_t dataSize = m.cols * m.rows * m.elemSize();
+			size_t rowSize = m.cols * elemSize;
 
-			for( size_t dc = 0; dc < dataSize; ++dc )
-				ar & m.data[ dc ];
+			if( m.isContinuous() )
+				ar & make_array( m.data, rowSize * m.rows );
+			else
+				for( int r = 0; r < m.rows; r++ )
+					ar & make_array( m.data + r * m.step, rowSize );
 		}
 
 		template< class Archive >
@@ -39,57 +60,30 @@ namespace boost {
 			ar & elemSize;
 			ar & elemType;
 
+			// NOTE create() may keep the buffer of m, that could be a non continuous ROI
 			m.create( rows, cols, elemType );
-			size_t dataSize = m.cols * m.rows * elemSize;
+			size_t rowSize = m.cols * elemSize;
 
-			for( size_t dc = 0; dc < dataSize; ++dc )
-				ar & m.data[ dc ];
+			if( m.isContinuous() )
+				ar & make_array( m.data, rowSize * m.rows );
+			else
+				for( int r = 0; r < m.rows; r++ )
+					ar & make_array( m.data + r * m.step, rowSize );
 		}
-	}
-}
 
-// If you can get this to work then I hate you
-/*BOOST_SERIALIZATION_SPLIT_FREE( cv::Point_<float> )
-namespace boost {
-	namespace serialization {
 		// Serialization for the cv::Point2f class
 		template< class Archive >
-		void save( Archive& ar, const cv::Point_<float>& p, const unsigned int version )
+		void serialize( Archive& ar, cv::Point2f& p, const unsigned int version )
 		{
 			ar & p.x;
 			ar & p.y;
 		}
 
-		template< class Archive >
-		void load( Archive& ar, const cv::Point_<float>& p, const unsigned int version )
-		{
-			ar & p.x;
-			ar & p.y;
-		}
-	}
-}
-
-BOOST_SERIALIZATION_SPLIT_FREE( cv::KeyPoint )
-namespace boost {
-	namespace serialization {
 		// Serialization for the cv::Keypoint class
 		template< class Archive >
-		void save( Archive& ar, const cv::KeyPoint& p, const unsigned int version )
+		void serialize( Archive& ar, cv::KeyPoint& p, const unsigned int version )
 		{
-			ar & p.pt.x;
-			ar & p.pt.y;
-			ar & p.size;
-			ar & p.angle;
-			ar & p.response;
-			ar & p.octave;
-			ar & p.class_id;
-		}
-
-		template< class Archive >
-		void load( Archive& ar, const cv::KeyPoint& p, const unsigned int version )
-		{
-			ar & p.pt.x;
-			ar & p.pt.y;
+			ar & p.pt;
 			ar & p.size;
 			ar & p.angle;
 			ar & p.response;
@@ -97,4 +91,15 @@ namespace boost {
 			ar & p.class_id;
 		}
 	}
-}*/
+}
+
+// Plain structures: no class information nor object tracking, and vectors of them are written in bulk
+BOOST_IS_BITWISE_SERIALIZABLE( cv::Point2f )
+BOOST_CLASS_IMPLEMENTATION( cv::Point2f, boost::serialization::object_serializable )
+BOOST_CLASS_TRACKING( cv::Point2f, boost::serialization::track_never )
+
+BOOST_IS_BITWISE_SERIALIZABLE( cv::KeyPoint )
+BOOST_CLASS_IMPLEMENTATION( cv::KeyPoint, boost::serialization::object_serializable )
+BOOST_CLASS_TRACKING( cv::KeyPoint, boost::serialization::track_never )
+
+#endif
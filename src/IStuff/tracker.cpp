@@ -23,9 +23,13 @@ const Size Tracker::LK_WINDOW = cv::Size(15, 15);
  * @brief Constructs a structure used to track 3D objects inside a video stream.
  */
 Tracker::Tracker()
+  : m_reference_spread(0), m_reference_end(0), m_recognizing(false),
+    m_motion_model(MOTION_LOCAL), m_forward_backward(false)
 {
   m_detector = FeatureDetector::create("GFTT");
-  m_matcher = DescriptorMatcher::create("FlannBased");
+
+  // The frames recorded, plus the last frame and the one being downscaled
+  FramePool::shared().reserve(m_queue.capacity() + 2);
 
   if (debug)
     cerr << TAG << " constructed.\n";
@@ -37,25 +41,64 @@ Tracker::~Tracker()
 /* Setters */
 
 /**
- * @brief Method used by this IStuff::Tracker's thread to mark itself as running.
+ * @brief Sets how the labels are moved by the tracked features.
+ * @details To be called before tracking.
+ *
+ * @param[in] model  The IStuff::Tracker::MotionModel, MOTION_LOCAL by default.
+ */
+void Tracker::setMotionModel(MotionModel model)
+{
+  m_motion_model = model;
+}
+
+/**
+ * @brief Sets whether the features are tracked back to the old frame, and
+ *  dropped if they don't come back where they were.
+ * @details To be called before tracking. It doubles the optical flow
+ *  computation, so it's off by default.
  *
- * @param[in] running The status to assign to the thread.
+ * @param[in] enabled  `true` to check the features.
  */
-void Tracker::setRunning(bool running)
+void Tracker::setForwardBackward(bool enabled)
 {
-  m_running = running;
+  m_forward_backward = enabled;
 }
 
 /* Getters */
 
 /**
- * @brief Checks whether this IStuff::Tracker has a thread up and running.
+ * @brief Checks whether this IStuff::Tracker is tracking in background.
  *
  * @return `true` if tracking, `false` otherwise.
  */
 bool Tracker::isRunning() const
 {
-  return m_running;
+  return m_worker.isBusy();
+}
+
+/**
+ * @brief Returns how well the last frame was tracked.
+ *
+ * @return The IStuff::TrackingQuality of the last frame.
+ */
+TrackingQuality Tracker::getQuality()
+{
+  lock_guard<mutex> lock(m_object_mutex);
+
+  return m_quality;
+}
+
+/**
+ * @brief Returns the last frame painted for debugging.
+ * @details The features and the labels are painted only with debug on.
+ *
+ * @return The painted frame, empty if none is.
+ */
+Mat Tracker::getDebugImage()
+{
+  lock_guard<mutex> lock(m_object_mutex);
+
+  return m_debug_image;
 }
 
 /* Other methods */
@@ -76,30 +119,42 @@ Object Tracker::trackFrame(Mat new_frame)
     cerr << TAG << ": Tracking frame.\n";
 
   Object new_object;
-  Mat small_new_frame;
+  Mat small_new_frame = downscale(new_frame);
   Features new_features;
 
-  resize(new_frame, small_new_frame, Size(),
-         IMG_RESIZE, IMG_RESIZE, INTER_AREA);
-
   lock_guard<mutex> lock(m_object_mutex);
 
   // Syncrhonizing this whole operation ensures no writing occurs
   // during this tracking
-  new_features = calcFeatures(m_frame, small_new_frame, &m_features);
-  new_object = updateObject(m_features, new_features, m_object);
+  float error = 0;
+  buildPyramid(small_new_frame, m_next_pyramid);
+  new_features = calcFeatures(m_pyramid, m_next_pyramid, m_features, &error);
+  new_object = updateObject(m_features.getPositions(), new_features, m_object,
+                            m_nearest_features);
+  m_features.setPositions(new_features);
+
+  // The features lost are replaced by new ones, not around the tracked ones
+  if (!m_recognizing)
+    replenishFeatures(small_new_frame, m_features);
+
+  // Only the survivors of the recognition tell how the tracking goes
+  m_quality.features = m_features.countBefore(m_reference_end);
+  m_quality.replenished = m_features.size() - m_quality.features;
+  m_quality.error = error;
+  m_quality.spread = m_reference_spread > 0 ?
+    labelSpread(new_object) / m_reference_spread : 1;
 
   if (debug)
   {
     Mat display = m_display.clone();
 
-    for (size_t i = 0; i < new_features.size(); i++)
+    for (size_t i = 0; i < m_features.size(); i++)
     {
       line(display,
-           m_saved_features[i] * 2,
-           new_features[i] * 2,
+           m_features.getSaved()[i] * 2,
+           m_features.getPositions()[i] * 2,
            Scalar(255, 255, 0));
-      circle(display, new_features[i] * 2, 5, Scalar(255, 0, 0));
+      circle(display, m_features.getPositions()[i] * 2, 5, Scalar(255, 0, 0));
     }
 
     for (size_t i = 0; i < new_object.getLabels().size(); i++)
@@ -112,16 +167,17 @@ Object Tracker::trackFrame(Mat new_frame)
       circle(display, new_position, 5, Scalar(255, 255, 0));
     }
 
-    imshow("Tracker", new_object.paint(display));
-
-    int key = waitKey(30);
-    if (key != -1)
-      waitKey(0);
+    // Shown by the main thread, see getDebugImage()
+    m_debug_image = new_object.paint(display);
   }
 
   m_object = new_object;
   m_frame = small_new_frame;
-  m_features = new_features;
+  m_pyramid.swap(m_next_pyramid);
+
+  // Recorded once tracked, so that the last frame recorded is m_frame.
+  // Never waits, neither for the recognition nor for the queue consumer
+  m_queue.enqueue(small_new_frame);
 
   return new_object;
 }
@@ -153,41 +209,82 @@ Features Tracker::calcFeatures(cv::Mat frame)
 
 /**
  * @brief Method to track IStuff:Features between frames.
+ * @details The frames are given as pyramids, see buildPyramid(), so that the
+ *  one of a frame is built once and used both when it's the new frame and when
+ *  it's the old one.
+ *
+ *  The untracked features are removed from the IStuff::FeatureTable in a
+ *  single pass, together with the new positions.
  *
- * @param[in]     old_frame     The frame relative to the given IStuff::Features.
- * @param[in]     new_frame     The frame where to track the IStuff::Features.
- * @param[in,out] old_features  The old IStuff::Features, returned erased of the untracked features.
+ * @param[in]     old_pyramid  The pyramid of the frame relative to the given IStuff::Features.
+ * @param[in]     new_pyramid  The pyramid of the frame where to track the IStuff::Features.
+ * @param[in,out] features     The IStuff::FeatureTable of the old frame,
+ *  returned erased of the untracked features, all of them if a frame is empty.
+ * @param[out]    mean_error   The mean error of the features tracked,
+ *  0 if none is (optional).
  *
- * @return The IStuff::Features of the old frame relative to the new frame.
+ * @return The IStuff::Features of the old frame relative to the new frame,
+ *  in step with the IStuff::FeatureTable.
  */
-Features Tracker::calcFeatures(cv::Mat old_frame, cv::Mat new_frame,
-                               Features* old_features)
+Features Tracker::calcFeatures(const Pyramid& old_pyramid,
+                               const Pyramid& new_pyramid,
+                               FeatureTable& features,
+                               float* mean_error)
 {
   if (debug)
     cerr << TAG << ": calcFeatures (optical flow).\n";
 
   Features new_features;
 
-  if (old_features->empty() || new_frame.empty())
+  if (mean_error)
+    *mean_error = 0;
+
+  if (old_pyramid.empty() || new_pyramid.empty())
+    features.clear();
+
+  if (features.empty())
     return new_features;
 
   vector<uchar> status;
   vector<float> error;
-  calcOpticalFlowPyrLK(old_frame, new_frame,
-                       *old_features, new_features,
-                       status, error, LK_WINDOW);
+  calcOpticalFlowPyrLK(old_pyramid, new_pyramid,
+                       features.getPositions(), new_features,
+                       status, error, LK_WINDOW, LK_LEVELS);
+
+  // A feature not tracked back to where it was has drifted, even if found
+  if (m_forward_backward)
+  {
+    Features back_features;
+    vector<uchar> back_status;
+    vector<float> back_error;
+    calcOpticalFlowPyrLK(new_pyramid, old_pyramid,
+                         new_features, back_features,
+                         back_status, back_error, LK_WINDOW, LK_LEVELS);
+
+    for (size_t i = 0; i < status.size(); i++)
+      if (status[i] && (!back_status[i] ||
+          norm(back_features[i] - features.getPositions()[i]) > FB_MAX_ERROR))
+        status[i] = 0;
+  }
 
   if (debug)
     cerr << TAG << ": Points tracked.\n";
 
-  for (int i = status.size()-1; i >= 0; i--)
-    if (!status[i])
-    {
-      old_features->erase(old_features->begin() + i);
-      new_features.erase(new_features.begin() + i);
+  if (mean_error)
+  {
+    size_t tracked = 0;
+    for (size_t i = 0; i < status.size(); i++)
+      if (status[i])
+      {
+        *mean_error += error[i];
+        tracked++;
+      }
 
-      m_saved_features.erase(m_saved_features.begin() + i);
-    }
+    if (tracked > 0)
+      *mean_error /= tracked;
+  }
+
+  features.compact(status, &new_features);
 
   if (debug)
     cerr << TAG << ": " << new_features.size() << " points remained.\n";
@@ -195,20 +292,46 @@ Features Tracker::calcFeatures(cv::Mat old_frame, cv::Mat new_frame,
   return new_features;
 }
 
+/**
+ * @brief Builds the pyramid calcFeatures() tracks a frame with.
+ * @details The derivatives are included, so that the pyramid can be used for
+ *  the old frame too. The buffers of the pyramid are reused when it has
+ *  already been built for a frame of the same size.
+ *
+ * @param[in]  frame    The frame, downscaled.
+ * @param[out] pyramid  The pyramid of the frame, empty if the frame is.
+ */
+void Tracker::buildPyramid(Mat frame, Pyramid& pyramid)
+{
+  if (frame.empty())
+  {
+    pyramid.clear();
+    return;
+  }
+
+  buildOpticalFlowPyramid(frame, pyramid, LK_WINDOW, LK_LEVELS);
+}
+
 /**
  * @brief Function to update an IStuff::Object from an old position to its new one.
- * @details This method calculates the new position by mediating the movement
+ * @details With a IStuff::Tracker::MotionModel other than MOTION_LOCAL, every
+ *  IStuff::Label is moved by the motion fitted to all the features, see
+ *  fitMotion(). Otherwise, or if the fit fails, this method calculates the
+ *  new position by mediating the movement
  *	of the nearest IStuff::Tracker::NEAREST_FEATURES_COUNT features to every
- *	point of every IStuff::Label of the IStuff::Object.
+ *	point of every IStuff::Label of the IStuff::Object, or of all the features
+ *	if they are fewer.
  *
  * @param[in] old_features  The IStuff::Features relative to the IStuff::Object.
  * @param[in] new_features  The IStuff::Features for the new IStuff:Object.
  * @param[in] old_object    The IStuff::Object to be updated.
+ * @param[in] index         The IStuff::PointIndex used to search the old
+ *  IStuff::Features, not used by other threads meanwhile.
  *
  * @return	The new IStuff::Object, moved according to the IStuff::Features.
  */
 Object Tracker::updateObject(Features old_features, Features new_features,
-                             Object old_object)
+                             Object old_object, PointIndex& index)
 {
   if (debug)
     cerr << TAG << ": Updating object.\n";
@@ -216,51 +339,372 @@ Object Tracker::updateObject(Features old_features, Features new_features,
   if (old_object.empty() || old_features.empty())
     return old_object;
 
-  vector<Label> labels = old_object.getLabels();
-  vector<Point2f> old_positions;
-  for (Label a_label : labels)
-    old_positions.push_back(a_label.position * .5);
+  // The features are in the downscaled frame, the labels in the original one
+  Mat motion = fitMotion(old_features, new_features);
 
+  if (!motion.empty())
+  {
+    vector<Label> labels = old_object.getLabels();
+    Features positions,
+             moved;
 
-  // Organize data as DescriptorMatcher wants it
-  Mat positions,
-      features,
-      temp[2];
-  split(Mat(old_positions), temp);
-  hconcat(temp[0], temp[1], positions);
-  split(Mat(old_features), temp);
-  hconcat(temp[0], temp[1], features);
+    for (Label a_label : labels)
+      positions.push_back(a_label.position * .5);
 
-  vector< vector<DMatch> > matches;
-  m_matcher->knnMatch(positions, features, matches, NEAREST_FEATURES_COUNT);
+    if (motion.rows == 3)
+      perspectiveTransform(positions, moved, motion);
+    else
+      transform(positions, moved, motion);
+
+    Object new_object;
+    for (size_t i = 0; i < labels.size(); i++)
+    {
+      labels[i].position = moved[i] * 2;
+      new_object.addLabel(labels[i]);
+    }
+
+    return new_object;
+  }
+
+  index.build(old_features);
+
+  size_t count = min((size_t) NEAREST_FEATURES_COUNT, old_features.size());
+  vector<int> nearest;
 
   Object new_object;
-  for (size_t i = 0; i < matches.size(); i++) 
+  for (Label a_label : old_object.getLabels())
   {
+    index.nearest(a_label.position * .5, count, nearest);
+
     Point2f movement;
-    for (size_t j = 0; j < NEAREST_FEATURES_COUNT; j++)
-    {
-      size_t feature_index = matches[i][j].trainIdx;
+    for (int feature_index : nearest)
       movement += new_features[feature_index] - old_features[feature_index];
-    }
-    movement = movement * (1. / NEAREST_FEATURES_COUNT);
+    movement = movement * (1. / count);
 
-    size_t label_index = matches[i][0].queryIdx;
-    Label new_label = labels[label_index];
-    new_label.position += movement * 2;
-    new_object.addLabel(new_label);
+    a_label.position += movement * 2;
+    new_object.addLabel(a_label);
   }
 
   return new_object;
 }
 
+/**
+ * @brief Fits the IStuff::Tracker::MotionModel to the movement of the features.
+ * @details The similarity and the affine motion are estimated with
+ *  estimateRigidTransform(), the homography with RANSAC; either way the
+ *  features moving against the others are left out as outliers.
+ *
+ * @param[in] old_features  The IStuff::Features in the old frame.
+ * @param[in] new_features  The same IStuff::Features in the new frame.
+ *
+ * @return The 2x3 or 3x3 transformation from the old frame to the new one,
+ *  empty with MOTION_LOCAL, with less than
+ *  IStuff::Tracker::MIN_MODEL_FEATURES features or if the fit fails.
+ */
+Mat Tracker::fitMotion(const Features& old_features,
+                       const Features& new_features) const
+{
+  if (old_features.size() < MIN_MODEL_FEATURES)
+    return Mat();
+
+  Mat motion;
+
+  switch (m_motion_model)
+  {
+    case MOTION_SIMILARITY:
+      motion = estimateRigidTransform(old_features, new_features, false);
+      break;
+
+    case MOTION_AFFINE:
+      motion = estimateRigidTransform(old_features, new_features, true);
+      break;
+
+    case MOTION_HOMOGRAPHY:
+      motion = findHomography(old_features, new_features, CV_RANSAC,
+                              HOMOGRAPHY_THRESHOLD);
+      break;
+
+    default:
+      break;
+  }
+
+  if (debug && m_motion_model != MOTION_LOCAL && motion.empty())
+    cerr << TAG << ": Motion not fitted, using the local mean.\n";
+
+  return motion;
+}
+
+/**
+ * @brief Detects new IStuff::Features where the tracked ones have thinned out.
+ * @details Nothing happens while enough of the features detected at the last
+ *  recognition are tracked, see IStuff::Tracker::REPLENISH_BELOW. Otherwise the
+ *  frame is divided in a grid of IStuff::Tracker::REPLENISH_GRID cells per
+ *  side and the cells with less features than their share are searched,
+ *  emptiest first, masking the surroundings of the tracked features; the
+ *  strongest corners found are added.<br />
+ *  The search stops after IStuff::Tracker::REPLENISH_BUDGET milliseconds,
+ *  leaving the remaining cells to the next frames.
+ *
+ * @param[in]     frame     The frame, downscaled, the IStuff::Features are in.
+ * @param[in,out] features  The IStuff::FeatureTable of the frame, returned
+ *  with the new features appended.
+ *
+ * @return The number of IStuff::Features added.
+ */
+size_t Tracker::replenishFeatures(Mat frame, FeatureTable& features)
+{
+  typedef boost::chrono::steady_clock Clock;
+
+  size_t target = m_quality.reference_features;
+
+  if (frame.empty() || features.size() >= target * REPLENISH_BELOW)
+    return 0;
+
+  Clock::time_point deadline = Clock::now() +
+                               boost::chrono::milliseconds(REPLENISH_BUDGET);
+  int cells = REPLENISH_GRID * REPLENISH_GRID;
+  size_t share = max((size_t) 1, target / cells),
+         added = 0;
+
+  // The features in every cell, and where new ones can be
+  vector<size_t> counts(cells, 0);
+  m_replenish_mask.create(frame.size(), CV_8UC1);
+  m_replenish_mask.setTo(Scalar(255));
+
+  for (Point2f a_feature : features.getPositions())
+  {
+    int column = min(max((int) (a_feature.x * REPLENISH_GRID / frame.cols), 0),
+                     REPLENISH_GRID - 1),
+        row = min(max((int) (a_feature.y * REPLENISH_GRID / frame.rows), 0),
+                  REPLENISH_GRID - 1);
+
+    counts[row * REPLENISH_GRID + column]++;
+    circle(m_replenish_mask, a_feature, REPLENISH_DISTANCE, Scalar(0), -1);
+  }
+
+  // The emptiest cells first
+  vector<int> order;
+  for (int cell = 0; cell < cells; cell++)
+    if (counts[cell] < share)
+      order.push_back(cell);
+
+  stable_sort(order.begin(), order.end(), [&](int a, int b)
+  {
+    return counts[a] < counts[b];
+  });
+
+  vector<KeyPoint> key_points;
+  for (int cell : order)
+  {
+    if (features.size() >= target || Clock::now() >= deadline)
+      break;
+
+    Rect area(cell % REPLENISH_GRID * frame.cols / REPLENISH_GRID,
+              cell / REPLENISH_GRID * frame.rows / REPLENISH_GRID,
+              frame.cols / REPLENISH_GRID,
+              frame.rows / REPLENISH_GRID);
+
+    m_detector->detect(frame(area), key_points, m_replenish_mask(area));
+
+    sort(key_points.begin(), key_points.end(),
+         [](const KeyPoint& a, const KeyPoint& b)
+    {
+      return a.response > b.response;
+    });
+
+    size_t count = min(min(key_points.size(), share - counts[cell]),
+                       target - features.size());
+
+    for (size_t i = 0; i < count; i++)
+      features.add(key_points[i].pt + Point2f(area.x, area.y));
+
+    added += count;
+  }
+
+  if (debug)
+    cerr << TAG << ": " << added << " features added.\n";
+
+  return added;
+}
+
+/**
+ * @brief Brings a recognized IStuff::Object from its frame to the current one.
+ * @details The frames recorded in the IStuff::FakableQueue since the
+ *  recognized one are tracked again, one after the other, moving the
+ *  IStuff::Object with the features around it at every step. This happens
+ *  without holding the lock, while new frames keep being tracked and recorded;
+ *  only the frames recorded meanwhile are replayed synchronized, so that the
+ *  result is in step with m_frame.<br />
+ *  Replaying stops after REPLAY_BUDGET milliseconds, then the IStuff::Object
+ *  jumps to m_frame in a single step. If the replay isn't possible, or loses
+ *  every feature, the IStuff::Object is moved from the saved IStuff::Features
+ *  to the current ones, as without a replay.
+ *
+ * @param[in] recognized  The IStuff::Object found in the recognized frame.
+ *
+ * @return The IStuff::Object in the current frame, which is also set.
+ */
+Object Tracker::replayRecognition(Object recognized)
+{
+  typedef boost::chrono::steady_clock Clock;
+
+  Clock::time_point deadline = Clock::now() +
+                               boost::chrono::milliseconds(REPLAY_BUDGET);
+  Object object = recognized;
+  FeatureTable features;
+  Mat frame,
+      last_frame;
+  size_t replayed = 0;
+
+  {
+    lock_guard<mutex> lock(m_object_mutex);
+
+    // The features of the recognized frame that are still tracked, there
+    features = m_features;
+    Features saved = features.getSaved();
+    features.setPositions(saved);
+  }
+
+  // The queue goes back to the recognized frame
+  m_queue.discard();
+
+  bool replaying = m_queue.isStarted() && !features.empty() &&
+                   m_queue.tryDequeue(last_frame);
+
+  if (replaying)
+    buildPyramid(last_frame, m_replay_pyramid);
+
+  // Replays the recorded frames until they're over, or the time is
+  auto replayRecorded = [&]()
+  {
+    while (replaying && Clock::now() < deadline && m_queue.tryDequeue(frame))
+    {
+      buildPyramid(frame, m_replay_next_pyramid);
+      replaying = replayFrame(m_replay_next_pyramid, features, object);
+      m_replay_pyramid.swap(m_replay_next_pyramid);
+
+      last_frame = frame;
+      replayed++;
+    }
+  };
+
+  replayRecorded();
+
+  lock_guard<mutex> lock(m_object_mutex);
+
+  // Nothing is recorded while synchronized: this reaches m_frame
+  replayRecorded();
+
+  // Frames dropped by the queue, or not replayed in time, are jumped over
+  if (replaying && last_frame.data != m_frame.data)
+    replaying = replayFrame(m_pyramid, features, object);
+
+  if (!replaying)
+    object = updateObject(m_features.getSaved(), m_features.getPositions(),
+                          recognized, m_nearest_features);
+
+  // The spread of the labels just recognized is the reference
+  m_reference_spread = labelSpread(object);
+  m_quality.features = m_features.countBefore(m_reference_end);
+  m_quality.spread = 1;
+  m_recognizing = false;
+
+  if (debug)
+    cerr << TAG << ": " << replayed << " frames replayed"
+      << (replaying ? ".\n" : ", replay failed.\n");
+
+  // Drop the frames, so that the queue never fills up
+  m_queue.stop();
+  m_queue.clear();
+
+  m_object = object;
+
+  return object;
+}
+
+/**
+ * @brief Tracks the replayed IStuff::Object to the next recorded frame.
+ *
+ * @param[in]     next_pyramid  The pyramid of the next frame, the one of the
+ *  replayed frame being m_replay_pyramid.
+ * @param[in,out] features      The features of the replayed frame, then of
+ *  the next one.
+ * @param[in,out] object        The IStuff::Object in the replayed frame, then
+ *  in the next one.
+ *
+ * @return `false` if every feature is lost.
+ */
+bool Tracker::replayFrame(const Pyramid& next_pyramid, FeatureTable& features,
+                          Object& object)
+{
+  Features next_features = calcFeatures(m_replay_pyramid, next_pyramid,
+                                        features);
+
+  if (next_features.empty())
+    return false;
+
+  object = updateObject(features.getPositions(), next_features, object,
+                        m_replay_nearest_features);
+  features.setPositions(next_features);
+
+  return true;
+}
+
+/**
+ * @brief Downscales a frame by IStuff::Tracker::IMG_RESIZE.
+ * @details The result is written in a buffer of the shared IStuff::FramePool.
+ *
+ * @param[in] frame The frame to be downscaled.
+ *
+ * @return The downscaled frame.
+ */
+Mat Tracker::downscale(Mat frame)
+{
+  Size small_size(saturate_cast<int>(frame.cols * IMG_RESIZE),
+                  saturate_cast<int>(frame.rows * IMG_RESIZE));
+
+  Mat small_frame = FramePool::shared().acquire(small_size, frame.type());
+  resize(frame, small_frame, small_size, 0, 0, INTER_AREA);
+
+  return small_frame;
+}
+
+/**
+ * @brief Measures how far the labels of an IStuff::Object are from their center.
+ *
+ * @param[in] object  The IStuff::Object.
+ *
+ * @return The mean distance of the labels from their centroid, 0 with less
+ *  than two labels.
+ */
+float Tracker::labelSpread(const Object& object)
+{
+  vector<Label> labels = object.getLabels();
+
+  if (labels.size() < 2)
+    return 0;
+
+  Point2f center;
+  for (Label a_label : labels)
+    center += a_label.position;
+  center = center * (1. / labels.size());
+
+  float spread = 0;
+  for (Label a_label : labels)
+    spread += norm(a_label.position - center);
+
+  return spread / labels.size();
+}
+
 /**
  * @brief Method to do the tracking process in a separate thread.
+ * @details The tracking is run by the IStuff::Worker of this IStuff::Tracker,
+ *  which is busy as soon as this returns.
  *
  * @param[in] frame     The frame to be tracked for an IStuff::Object.
  * @param[in] reference The reference to the IStuff::Manager to inform of the result.
  *
- * @return `true` if the thread is started, `false` if it was already running.
+ * @return `true` if the tracking is started, `false` if one was already running.
  */
 bool Tracker::backgroundTrackFrame(Mat frame, Manager* reference)
 {
@@ -276,17 +720,11 @@ bool Tracker::backgroundTrackFrame(Mat frame, Manager* reference)
     cerr << TAG << ": Starting in background.\n";
 
   // NOTE: "[=]" means "all used variables are captured in the lambda".
-  m_thread = auto_ptr<thread>(new thread([=]()
+  return m_worker.submit([=]()
   {
-    setRunning(true);
-
     Object new_object = trackFrame(frame);
     reference->sendMessage(Manager::MSG_TRACKING_END, &new_object);
-
-    setRunning(false);
-  }));
-
-  return true;
+  });
 }
 
 /**
@@ -298,12 +736,13 @@ bool Tracker::backgroundTrackFrame(Mat frame, Manager* reference)
  *    This message's handling is synchronized.<br />
  *    The frame received is downscaled, then IStuff::Features are calculated and
  *    the actual IStuff::Object is updated according to this frame.
- *    The IStuff::Features are saved for use when the recognition ends.</dd>
+ *    The IStuff::Features are saved for use when the recognition ends, and the
+ *    frames tracked from this one on are recorded in the IStuff::FakableQueue.</dd>
  *    <dt>IStuff::Manager::MSG_RECOGNITION_END</dt>
  *    <dd>data: IStuff::Object<br />
- *    This message's handling is synchronized.<br />
  *    This causes the IStuff::Tracker to actualize the new IStuff::Object by
- *    tracking it from the saved IStuff::Features and the current ones.</dd>
+ *    replaying the frames recorded since the recognized one, see
+ *    replayRecognition().</dd>
  *  </dl>
  *
  * @param[in] msg       The message identifier.
@@ -320,41 +759,58 @@ void Tracker::sendMessage(int msg, void* data, void* reply_to)
       {
         lock_guard<mutex> lock(m_object_mutex);
 
-        Mat frame;
-        resize(*(Mat*)data, frame, Size(), IMG_RESIZE, IMG_RESIZE, INTER_AREA);
+        Mat frame = downscale(*(Mat*)data);
+
+        // Record the frames tracked during the recognition
+        if (!m_queue.start(frame) && debug)
+          cerr << TAG << ": Frame queue full, not recording.\n";
 
         // Calcolo le features per il frame,
         // traccio al contrario derivando le features relative al vecchio frame
         // aggiorno l'oggetto tra i due frames
         // salvo il frame
-        m_saved_features = calcFeatures(frame);
-        temp_features = m_saved_features;
-        m_features = calcFeatures(frame, m_frame, &temp_features);
-        m_object = updateObject(m_features, m_saved_features, m_object);
+        m_features.assign(calcFeatures(frame));
+        buildPyramid(frame, m_next_pyramid);
+
+        // Nothing to track back to, before the first frame
+        if (!m_pyramid.empty())
+        {
+          temp_features = calcFeatures(m_next_pyramid, m_pyramid, m_features);
+          m_object = updateObject(temp_features, m_features.getPositions(),
+                                  m_object, m_nearest_features);
+        }
+
         m_frame = frame;
-        m_features = m_saved_features;
+        m_pyramid.swap(m_next_pyramid);
+
+        m_reference_end = m_features.getNextId();
+        m_quality.features = m_features.size();
+        m_quality.reference_features = m_features.size();
+        m_quality.replenished = 0;
+        m_recognizing = true;
 
         if (debug)
         {
           m_display = (*(Mat*)data).clone();
           
-          for (Point2f a_feature : m_saved_features)
+          for (Point2f a_feature : m_features.getSaved())
             circle(m_display, a_feature * 2, 4, Scalar(0, 255, 0));
 
-          imshow("Tracker", m_display);
+          m_debug_image = m_display;
         }
       }
       break;
 
     case Manager::MSG_RECOGNITION_END:
-      // Synchronized
+      // Synchronized only at the end of the replay
       {
-        lock_guard<mutex> lock(m_object_mutex);
-
         if (debug)
+        {
+          lock_guard<mutex> lock(m_object_mutex);
           m_original_object = *(Object*)data;
-        
-        m_object = updateObject(m_saved_features, m_features, *(Object*)data);
+        }
+
+        replayRecognition(*(Object*)data);
       }
       break;
 
@@ -13,14 +13,21 @@
 #include <map>
 
 #include <boost/thread.hpp>
+#include <boost/chrono.hpp>
 
 #include "opencv2/highgui/highgui.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
 #include "opencv2/video/video.hpp"
+#include "opencv2/calib3d/calib3d.hpp"
 #include "opencv2/nonfree/nonfree.hpp"
 
 #include "object.h"
 #include "fakable_queue.h"
+#include "frame_pool.h"
+#include "worker.h"
+#include "point_index.h"
+#include "feature_table.h"
+#include "recognition_scheduler.h"
 
 extern bool debug;
 
@@ -36,27 +43,129 @@ namespace IStuff
   class Tracker
   {
     /* Attributes */
+    public:
+      /**
+       * @brief How the labels are moved by the tracked features.
+       */
+      enum MotionModel
+      {
+        // Mean movement of the features nearest to every label
+        MOTION_LOCAL,
+        // Rotation, uniform scale and translation of all the features
+        MOTION_SIMILARITY,
+        MOTION_AFFINE,
+        MOTION_HOMOGRAPHY
+      };
+
     private:
       const static char TAG[];
 
       const static int NEAREST_FEATURES_COUNT = 10;
       const static float constexpr IMG_RESIZE = .5;
       const static cv::Size LK_WINDOW;
+      // Pyramid levels above the frame, as calcOpticalFlowPyrLK uses by default
+      const static int LK_LEVELS = 3;
+      // Milliseconds spent replaying the recorded frames, before jumping to the last one
+      const static int REPLAY_BUDGET = 40;
+      // Under this fraction of the features detected, new ones are searched
+      const static float constexpr REPLENISH_BELOW = .8;
+      // Cells per side of the grid the frame is replenished by
+      const static int REPLENISH_GRID = 4;
+      // Pixels around a tracked feature where no new one is detected
+      const static int REPLENISH_DISTANCE = 5;
+      // Milliseconds spent detecting new features in a frame
+      const static int REPLENISH_BUDGET = 5;
+      // Pixels between a feature and where it's tracked back to, at most
+      const static float constexpr FB_MAX_ERROR = 1;
+      // Features needed to fit a motion model, else the local mean is used
+      const static size_t MIN_MODEL_FEATURES = 8;
+      // Pixels of reprojection error of the homography inliers
+      const static double constexpr HOMOGRAPHY_THRESHOLD = 2;
+
+      /**
+       * @brief A frame with its downscaled copies and their derivatives, as
+       *  calcOpticalFlowPyrLK uses them.
+       */
+      typedef std::vector<cv::Mat> Pyramid;
 
-      std::auto_ptr<boost::thread> m_thread;
-      bool m_running = false;
       boost::mutex m_object_mutex;
 
       Object m_object;
       cv::Mat m_frame;
-      Features m_features,
-               m_saved_features;
+      /**
+       * @brief The pyramid of m_frame, built when it was the new frame, and
+       *  the buffers for the pyramid of the next one: they are swapped.
+       */
+      Pyramid m_pyramid,
+              m_next_pyramid;
+      /**
+       * @brief The features tracked in m_frame, saved where they were detected.
+       */
+      FeatureTable m_features;
 
       cv::Mat m_display;
       Object m_original_object;
 
+      /**
+       * @brief The last frame painted for debugging, shown by the main thread
+       *  as HighGUI must stay there.
+       */
+      cv::Mat m_debug_image;
+
+      /**
+       * @brief How the last frame was tracked, and the label spread of the
+       *  last IStuff::Object recognized, which the spread is relative to.
+       */
+      TrackingQuality m_quality;
+      float m_reference_spread;
+      // Features with a lower identifier were detected by the last recognition
+      size_t m_reference_end;
+
+      /**
+       * @brief Whether a recognition is in progress, from its start to the
+       *  end of its replay: the saved features must stay those detected in the
+       *  recognized frame meanwhile, so no feature is added.
+       */
+      bool m_recognizing;
+
+      /**
+       * @brief The mask of the areas free from features, see replenishFeatures().
+       */
+      cv::Mat m_replenish_mask;
+
+      /**
+       * @brief The motion fitted to move the labels, and whether the features
+       *  are validated by tracking them back to the old frame.
+       */
+      MotionModel m_motion_model;
+      bool m_forward_backward;
+
+      /**
+       * @brief The frames tracked since the last recognition started.
+       */
+      FakableQueue m_queue;
+
       cv::Ptr<cv::FeatureDetector> m_detector;
-      cv::Ptr<cv::DescriptorMatcher> m_matcher;
+
+      /**
+       * @brief The old features, searched for the ones nearest to the labels.
+       */
+      PointIndex m_nearest_features;
+
+      /**
+       * @brief What the replay of the recorded frames uses, mostly without
+       *  holding m_object_mutex.
+       */
+      Pyramid m_replay_pyramid,
+              m_replay_next_pyramid;
+      PointIndex m_replay_nearest_features;
+
+      /**
+       * @brief The thread tracking in background, at most one frame at a time.
+       * @details Declared last, so that it's stopped before anything it uses
+       *  is destroyed.
+       */
+      Worker m_worker;
 
       /* Methods */
     public:
@@ -65,21 +174,30 @@ namespace IStuff
       virtual ~Tracker();
 
       /* Setters */
+      void setMotionModel(MotionModel);
+      void setForwardBackward(bool);
 
       /* Getters */
       bool isRunning() const;
+      TrackingQuality getQuality();
+      cv::Mat getDebugImage();
 
       /* Other methods */
       Object trackFrame(cv::Mat);
       void sendMessage(int, void*, void* = NULL);
     private:
-      /* Setters */
-      void setRunning(bool);
-
       /* Other methods */
       Features calcFeatures(cv::Mat);
-      Features calcFeatures(cv::Mat, cv::Mat, Features*);
-      Object updateObject(Features, Features, Object);
+      Features calcFeatures(const Pyramid&, const Pyramid&, FeatureTable&,
+                            float* = NULL);
+      void buildPyramid(cv::Mat, Pyramid&);
+      Object updateObject(Features, Features, Object, PointIndex&);
+      cv::Mat fitMotion(const Features&, const Features&) const;
+      size_t replenishFeatures(cv::Mat, FeatureTable&);
+      Object replayRecognition(Object);
+      bool replayFrame(const Pyramid&, FeatureTable&, Object&);
+      cv::Mat downscale(cv::Mat);
+      static float labelSpread(const Object&);
       bool backgroundTrackFrame(cv::Mat, Manager*);
   };
 }
@@ -0,0 +1,347 @@
+/**
+ * @file	vocabulary.cpp
+ * @brief	Definition for Vocabulary class
+ * @class	IStuff::Vocabulary
+ * @details	A bag of visual words over the descriptors of the samples of a
+ * 			Database, with an inverted file from every word to the samples
+ * 			containing it. Samples are ranked against a frame by the cosine
+ * 			similarity of their tf-idf weighted histograms, visiting only the
+ * 			samples sharing some word with the frame
+ * @version	0.1.0
+ * @date	2026-10-16
+ */
+
+#include "vocabulary.h"
+
+using namespace std;
+using namespace cv;
+using namespace IStuff;
+
+/**
+ * @brief	Constructor
+ * @details	The vocabulary is empty until it's trained or loaded
+ */
+Vocabulary::Vocabulary() :
+	binary( false ),
+	requestedSize( 0 )
+{
+
+}
+
+/**
+ * @brief	Destructor
+ */
+Vocabulary::~Vocabulary() {
+
+}
+
+/**
+ * @brief	Clusters the descriptors into words and indexes the samples
+ * @details	At most MAX_TRAINING_DESCRIPTORS descriptors, evenly spaced over
+ * 			all the samples, are clustered with k-means; every descriptor is
+ * 			then quantized to build the histograms of the samples
+ * @param[in] descriptors	The descriptors of every sample, in the Database order
+ * @param[in] wordCount	The number of words, lowered if there are less descriptors;
+ * 			it's remembered anyway, see getRequestedSize()
+ * @param[in] _binary	Whether the descriptors are binary strings
+ */
+void Vocabulary::train( const vector< Mat >& descriptors, int wordCount, bool _binary ) {
+	clear();
+	binary = _binary;
+	requestedSize = wordCount;
+
+	int total = 0;
+	for( vector< Mat >::const_iterator it = descriptors.begin(); it != descriptors.end(); it++ )
+		total += it -> rows;
+
+	int step = max( 1, ( total + MAX_TRAINING_DESCRIPTORS - 1 ) / MAX_TRAINING_DESCRIPTORS );
+	int row = 0;
+	Mat trainingSet;
+
+	for( vector< Mat >::const_iterator it = descriptors.begin(); it != descriptors.end(); it++ ) {
+		Mat sample = toFloat( *it );
+
+		for( int r = 0; r < sample.rows; r++ )
+			if( row++ % step == 0 )
+				trainingSet.push_back( sample.row( r ) );
+	}
+
+	wordCount = min( wordCount, trainingSet.rows );
+
+	if( wordCount <= 0 )
+		return;
+
+	Mat labels;
+	kmeans( trainingSet, wordCount, labels, TermCriteria( TermCriteria::COUNT + TermCriteria::EPS, KMEANS_ITERATIONS, 1e-3 ), 1, KMEANS_PP_CENTERS, words );
+
+	createIndex();
+
+	histograms.resize( descriptors.size() );
+
+	for( size_t i = 0; i < descriptors.size(); i++ )
+		histogram( descriptors[ i ], histograms[ i ] );
+
+	updateWeights();
+}
+
+/**
+ * @brief	Empties the vocabulary
+ */
+void Vocabulary::clear() {
+	wordIndex.release();
+	words.release();
+	requestedSize = 0;
+	histograms.clear();
+	postings.clear();
+	idf.clear();
+}
+
+/**
+ * @brief	Whether the vocabulary has been trained or loaded
+ */
+bool Vocabulary::empty() const {
+	return words.empty();
+}
+
+/**
+ * @brief	Returns the number of words
+ */
+int Vocabulary::size() const {
+	return words.rows;
+}
+
+/**
+ * @brief	Returns the number of words asked for when the vocabulary was trained
+ * @details	It's larger than size() when there were less descriptors than words,
+ * 			so that such a vocabulary isn't trained again with the same request
+ */
+int Vocabulary::getRequestedSize() const {
+	return requestedSize;
+}
+
+/**
+ * @brief	Indexes the descriptors of a sample
+ * @details	The words aren't clustered again, a vocabulary trained on a
+ * 			representative set of samples describes the new ones as well
+ * @param[in] index	The position of the sample, the number of samples to append it
+ * @param[in] descriptors	The descriptors of the sample
+ */
+void Vocabulary::setSample( size_t index, const Mat& descriptors ) {
+	if( index >= histograms.size() )
+		histograms.resize( index + 1 );
+
+	histogram( descriptors, histograms[ index ] );
+	updateWeights();
+}
+
+/**
+ * @brief	Removes a sample from the index
+ * @details	The following samples are shifted back by one, as in the Database
+ * @param[in] index	The position of the sample
+ */
+void Vocabulary::removeSample( size_t index ) {
+	if( index >= histograms.size() )
+		return;
+
+	histograms.erase( histograms.begin() + index );
+	updateWeights();
+}
+
+/**
+ * @brief	Finds the samples most similar to a frame
+ * @param[in] descriptors	The descriptors of the frame
+ * @param[in] count	The maximum number of samples returned
+ * @param[out] candidates	The positions of the samples, the most similar first.
+ * 			Samples sharing no word with the frame are never returned
+ */
+void Vocabulary::query( const Mat& descriptors, size_t count, vector< int >& candidates ) const {
+	candidates.clear();
+
+	if( empty() )
+		return;
+
+	vector< pair< int, float > > frameHistogram;
+	histogram( descriptors, frameHistogram );
+
+	float norm = 0;
+
+	for( vector< pair< int, float > >::iterator it = frameHistogram.begin(); it != frameHistogram.end(); it++ ) {
+		it -> second *= idf[ it -> first ];
+		norm += it -> second * it -> second;
+	}
+
+	if( norm == 0 )
+		return;
+
+	norm = sqrt( norm );
+
+	// Only the samples in the postings of the words of the frame are scored
+	vector< float > scores( histograms.size(), 0 );
+	vector< int > scored;
+
+	for( vector< pair< int, float > >::const_iterator word = frameHistogram.begin(); word != frameHistogram.end(); word++ )
+		for( vector< pair< int, float > >::const_iterator it = postings[ word -> first ].begin(); it != postings[ word -> first ].end(); it++ ) {
+			if( scores[ it -> first ] == 0 )
+				scored.push_back( it -> first );
+
+			scores[ it -> first ] += word -> second / norm * it -> second;
+		}
+
+	vector< pair< float, int > > ranking;
+	ranking.reserve( scored.size() );
+
+	for( vector< int >::iterator it = scored.begin(); it != scored.end(); it++ )
+		ranking.push_back( make_pair( scores[ *it ], *it ) );
+
+	count = min( count, ranking.size() );
+	partial_sort( ranking.begin(), ranking.begin() + count, ranking.end(), greater< pair< float, int > >() );
+
+	for( size_t i = 0; i < count; i++ )
+		candidates.push_back( ranking[ i ].second );
+}
+
+/**
+ * @brief	Writes the vocabulary and the histograms of the samples to a file
+ * @param[in] fileName	The file to be written
+ * @param[in] names	The names of the samples, checked when the file is loaded
+ * @retval	false if the file can't be written
+ */
+bool Vocabulary::save( const string& fileName, const vector< string >& names ) const {
+	ofstream file( fileName.c_str(), ios::binary );
+
+	if( !file )
+		return false;
+
+	boost::archive::binary_oarchive archive( file );
+	archive << names << binary << words << histograms << requestedSize;
+
+	return file.good();
+}
+
+/**
+ * @brief	Reads the vocabulary and the histograms of the samples from a file
+ * @param[in] fileName	The file to be read
+ * @param[in] names	The names of the current samples
+ * @retval	false if there's no file, or it's about other samples; the
+ * 			vocabulary is left empty
+ */
+bool Vocabulary::load( const string& fileName, const vector< string >& names ) {
+	clear();
+
+	ifstream file( fileName.c_str(), ios::binary );
+
+	if( !file )
+		return false;
+
+	vector< string > savedNames;
+
+	try {
+		boost::archive::binary_iarchive archive( file );
+		archive >> savedNames >> binary >> words >> histograms >> requestedSize;
+	} catch( boost::archive::archive_exception& e ) {
+		clear();
+		return false;
+	}
+
+	if( savedNames != names || words.empty() ) {
+		clear();
+		return false;
+	}
+
+	createIndex();
+	updateWeights();
+
+	return true;
+}
+
+/**
+ * @brief	Converts descriptors to the space the words are clustered in
+ * @details	Binary descriptors are unpacked to one float per bit, so that
+ * 			the squared euclidean distance is their Hamming distance
+ */
+Mat Vocabulary::toFloat( const Mat& descriptors ) const {
+	Mat converted;
+
+	if( !binary ) {
+		descriptors.convertTo( converted, CV_32F );
+		return converted;
+	}
+
+	converted.create( descriptors.rows, descriptors.cols * 8, CV_32F );
+
+	for( int r = 0; r < descriptors.rows; r++ ) {
+		const uchar* bytes = descriptors.ptr< uchar >( r );
+		float* bits = converted.ptr< float >( r );
+
+		for( int c = 0; c < descriptors.cols; c++ )
+			for( int b = 0; b < 8; b++ )
+				bits[ c * 8 + b ] = ( bytes[ c ] >> ( 7 - b ) ) & 1;
+	}
+
+	return converted;
+}
+
+/**
+ * @brief	Builds the search index over the words
+ * @details	The index refers to words, which must not change afterwards
+ */
+void Vocabulary::createIndex() {
+	wordIndex = new flann::Index( words, flann::KDTreeIndexParams( 4 ) );
+}
+
+/**
+ * @brief	Quantizes descriptors to their nearest words
+ * @param[in] descriptors	The descriptors of a sample or a frame
+ * @param[out] wordHistogram	The occurrences of every word, sorted by word
+ */
+void Vocabulary::histogram( const Mat& descriptors, vector< pair< int, float > >& wordHistogram ) const {
+	wordHistogram.clear();
+
+	if( descriptors.empty() )
+		return;
+
+	Mat indices, distances;
+	wordIndex -> knnSearch( toFloat( descriptors ), indices, distances, 1, flann::SearchParams( SEARCH_CHECKS ) );
+
+	vector< int > nearest( indices.begin< int >(), indices.end< int >() );
+	sort( nearest.begin(), nearest.end() );
+
+	for( vector< int >::iterator it = nearest.begin(); it != nearest.end(); it++ )
+		if( wordHistogram.empty() || wordHistogram.back().first != *it )
+			wordHistogram.push_back( make_pair( *it, 1.f ) );
+		else
+			wordHistogram.back().second++;
+}
+
+/**
+ * @brief	Rebuilds the inverse document frequencies and the inverted file
+ * @details	Linear in the size of the histograms, no descriptor is quantized
+ */
+void Vocabulary::updateWeights() {
+	idf.assign( words.rows, 0 );
+	postings.assign( words.rows, vector< pair< int, float > >() );
+
+	for( size_t s = 0; s < histograms.size(); s++ )
+		for( vector< pair< int, float > >::iterator it = histograms[ s ].begin(); it != histograms[ s ].end(); it++ )
+			idf[ it -> first ]++;
+
+	for( int w = 0; w < words.rows; w++ )
+		if( idf[ w ] > 0 )
+			idf[ w ] = log( histograms.size() / idf[ w ] );
+
+	for( size_t s = 0; s < histograms.size(); s++ ) {
+		float norm = 0;
+
+		for( vector< pair< int, float > >::iterator it = histograms[ s ].begin(); it != histograms[ s ].end(); it++ )
+			norm += pow( it -> second * idf[ it -> first ], 2 );
+
+		if( norm == 0 )
+			continue;
+
+		norm = sqrt( norm );
+
+		for( vector< pair< int, float > >::iterator it = histograms[ s ].begin(); it != histograms[ s ].end(); it++ )
+			if( idf[ it -> first ] > 0 )
+				postings[ it -> first ].push_back( make_pair( (int) s, it -> second * idf[ it -> first ] / norm ) );
+	}
+}
@@ -0,0 +1,85 @@
+/**
+* @file vocabulary.h
+* @brief Library for Vocabulary class
+* @version 0.1.0
+* @date 2026-10-16
+*/
+
+#ifndef VOCABULARY_H__
+#define VOCABULARY_H__
+
+// Standard C++ libraries
+#include <fstream>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+// OpenCV libraries
+#include "opencv2/core/core.hpp"
+#include "opencv2/flann/flann.hpp"
+
+// Boost libraries
+#include "boost/archive/binary_oarchive.hpp"
+#include "boost/archive/binary_iarchive.hpp"
+
+#include "boost/serialization/vector.hpp"
+#include "boost/serialization/string.hpp"
+#include "boost/serialization/utility.hpp"
+#include "serialize_opencv.h"
+
+namespace IStuff {
+	class Vocabulary {
+		private:
+			// Descriptors clustered into words, evenly sampled from every sample
+			// Static, so that a Vocabulary can be assigned
+			static const int MAX_TRAINING_DESCRIPTORS = 100000;
+			static const int KMEANS_ITERATIONS = 10;
+			static const int SEARCH_CHECKS = 32;
+
+			// Binary descriptors are clustered bit by bit
+			bool binary;
+
+			cv::Mat words;
+			// The words asked for, more than the words if there were less descriptors
+			int requestedSize;
+			// Searching doesn't change the index, but flann::Index::knnSearch() isn't const
+			mutable cv::Ptr< cv::flann::Index > wordIndex;
+
+			// Occurrences of every word in each sample, sorted by word
+			std::vector< std::vector< std::pair< int, float > > > histograms;
+
+			// Inverted file: the samples containing each word, with its normalized tf-idf weight
+			std::vector< std::vector< std::pair< int, float > > > postings;
+			std::vector< float > idf;
+
+		public:
+			Vocabulary();
+			virtual ~Vocabulary();
+
+			void train( const std::vector< cv::Mat >&, int, bool );
+			void clear();
+
+			bool empty() const;
+			int size() const;
+			int getRequestedSize() const;
+
+			void setSample( size_t, const cv::Mat& );
+			void removeSample( size_t );
+
+			void query( const cv::Mat&, size_t, std::vector< int >& ) const;
+
+			bool save( const std::string&, const std::vector< std::string >& ) const;
+			bool load( const std::string&, const std::vector< std::string >& );
+
+		private:
+			cv::Mat toFloat( const cv::Mat& ) const;
+			void createIndex();
+			void histogram( const cv::Mat&, std::vector< std::pair< int, float > >& ) const;
+			void updateWeights();
+	};
+};
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * @file worker.cpp
+ * @class IStuff::Worker
+ * @brief Class used to run tasks on a long lived thread.
+ * @details The thread is started with the IStuff::Worker and waits for the
+ *  tasks on an IStuff::BoundedQueue, running them in order; it's stopped and
+ *  joined when the IStuff::Worker is destroyed, after the pending tasks.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#include "worker.h"
+
+using namespace std;
+using namespace boost;
+using namespace IStuff;
+
+const char Worker::TAG[] = "Wrk";
+
+/* Constructors and Destructors */
+
+/**
+ * @brief Constructs the worker and starts its thread.
+ *
+ * @param[in] capacity  The number of tasks that can wait to be run.
+ */
+Worker::Worker(size_t capacity)
+  : m_tasks(capacity), m_pending(0)
+{
+  // Started last, when everything it uses is constructed
+  m_thread = boost::thread(&Worker::run, this);
+}
+
+/**
+ * @brief Runs the pending tasks, then stops the thread.
+ */
+Worker::~Worker()
+{
+  m_tasks.close();
+  m_thread.join();
+}
+
+/* Getters */
+
+/**
+ * @brief Checks whether a task is running or waiting to be run.
+ *
+ * @return `true` until every task submitted is completed.
+ */
+bool Worker::isBusy() const
+{
+  return m_pending.load() > 0;
+}
+
+/* Other methods */
+
+/**
+ * @brief Submits a task, without waiting.
+ *
+ * @param[in] task  The task to be run.
+ *
+ * @return `false` if too many tasks are waiting already.
+ */
+bool Worker::submit(const Task& task)
+{
+  // Counted before being queued, so that the worker is busy as soon as this returns
+  m_pending++;
+
+  if (!m_tasks.tryPush(task))
+  {
+    m_pending--;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Body of the thread: runs the tasks as they come.
+ */
+void Worker::run()
+{
+  Task a_task;
+
+  while (m_tasks.pop(a_task))
+  {
+    try
+    {
+      a_task();
+    }
+    catch (std::exception& e)
+    {
+      cerr << TAG << ": Task failed: " << e.what() << endl;
+    }
+
+    // Release what the task holds, frames included, before waiting again
+    a_task = Task();
+    m_pending--;
+  }
+}
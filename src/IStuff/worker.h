@@ -0,0 +1,62 @@
+/**
+ * @file worker.h
+ * @brief Header file for IStuff::Worker.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef I_STUFF_WORKER_H__
+#define I_STUFF_WORKER_H__
+
+#include <iostream>
+#include <atomic>
+#include <exception>
+
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+
+#include "bounded_queue.h"
+
+extern bool debug;
+
+namespace IStuff
+{
+  class Worker
+  {
+    /* Attributes */
+    public:
+      /**
+       * @brief A unit of work, run by the worker thread.
+       */
+      typedef boost::function<void ()> Task;
+
+    private:
+      const static char TAG[];
+
+      BoundedQueue<Task> m_tasks;
+
+      /**
+       * @brief Tasks submitted and not yet completed.
+       */
+      std::atomic<size_t> m_pending;
+
+      boost::thread m_thread;
+
+      /* Methods */
+    public:
+      /* Constructors and Destructors */
+      Worker(size_t = 1);
+      virtual ~Worker();
+
+      /* Getters */
+      bool isBusy() const;
+
+      /* Other methods */
+      bool submit(const Task&);
+
+    private:
+      void run();
+  };
+}
+
+#endif /* defined I_STUFF_WORKER_H__ */
@@ -0,0 +1,622 @@
+/**
+ * @file benchmark.cpp
+ * @brief Benchmarks runnable from the command line through `--benchmark`.
+ * @details Every benchmark prints a tab separated table on the standard
+ *  output, so that it can be easily compared between runs.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#include "benchmark.h"
+
+using namespace std;
+using namespace cv;
+using namespace IStuff;
+
+namespace fs = boost::filesystem;
+
+typedef boost::chrono::high_resolution_clock Clock;
+
+/**
+ * @brief An image with the IStuff::Label expected to be found on it.
+ */
+struct LabelledImage
+{
+  Mat image;
+  vector<Label> labels;
+};
+
+/**
+ * @brief Loads every image of a folder, along with its .lbl file if present.
+ *
+ * @param[in] folder  The folder containing the images.
+ *
+ * @return The images found, sorted by file name.
+ */
+static vector<LabelledImage> loadImages(const string& folder)
+{
+  vector<LabelledImage> images;
+  vector<fs::path> paths;
+
+  if (!fs::is_directory(folder))
+    return images;
+
+  for (fs::directory_iterator it(folder); it != fs::directory_iterator(); ++it)
+  {
+    fs::path extension = it->path().extension();
+
+    if (extension == ".jpg" || extension == ".png")
+      paths.push_back(it->path());
+  }
+
+  sort(paths.begin(), paths.end());
+
+  for (fs::path a_path : paths)
+  {
+    LabelledImage an_image;
+    an_image.image = imread(a_path.string());
+
+    ifstream label_file((a_path.parent_path() / a_path.stem()).string() + ".lbl");
+    string name;
+    float x, y;
+    while (label_file >> name >> x >> y)
+      an_image.labels.push_back(Label(name, Point2f(x, y), Scalar()));
+
+    images.push_back(an_image);
+  }
+
+  return images;
+}
+
+/**
+ * @brief A cv::Mat serialized one element at a time.
+ * @details This is the format written by serialize_opencv.h before its bulk
+ *  serialization, kept as a reference.
+ */
+struct BytewiseMat
+{
+  Mat mat;
+
+  template<class Archive>
+  void save(Archive& ar, const unsigned int version) const
+  {
+    size_t elem_size = mat.elemSize(),
+           elem_type = mat.type();
+
+    ar & mat.cols;
+    ar & mat.rows;
+    ar & elem_size;
+    ar & elem_type;
+
+    size_t data_size = mat.cols * mat.rows * elem_size;
+    for (size_t i = 0; i < data_size; i++)
+      ar & mat.data[i];
+  }
+
+  template<class Archive>
+  void load(Archive& ar, const unsigned int version)
+  {
+    int cols, rows;
+    size_t elem_size, elem_type;
+
+    ar & cols;
+    ar & rows;
+    ar & elem_size;
+    ar & elem_type;
+
+    mat.create(rows, cols, elem_type);
+
+    size_t data_size = mat.cols * mat.rows * elem_size;
+    for (size_t i = 0; i < data_size; i++)
+      ar & mat.data[i];
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+};
+
+/**
+ * @brief Checks whether two cv::Mat have the same geometry and elements.
+ */
+static bool sameMat(const Mat& a, const Mat& b)
+{
+  if (a.size() != b.size() || a.type() != b.type())
+    return false;
+
+  for (int r = 0; r < a.rows; r++)
+    if (memcmp(a.ptr(r), b.ptr(r), a.cols * a.elemSize()))
+      return false;
+
+  return true;
+}
+
+/**
+ * @brief Serializes an object to a binary archive in memory.
+ */
+template<class T>
+static string serialize(const T& object)
+{
+  ostringstream stream;
+  boost::archive::binary_oarchive archive(stream);
+  archive << object;
+
+  return stream.str();
+}
+
+/**
+ * @brief Deserializes an object from a binary archive in memory.
+ */
+template<class T>
+static void deserialize(const string& data, T& object)
+{
+  istringstream stream(data);
+  boost::archive::binary_iarchive archive(stream);
+  archive >> object;
+}
+
+/**
+ * @brief Removes every file of a database.
+ *
+ * @param[in] name  The name of the database.
+ */
+static void removeDatabase(const string& name)
+{
+  if (!fs::is_directory("database"))
+    return;
+
+  vector<fs::path> files;
+  for (fs::directory_iterator it("database"); it != fs::directory_iterator(); ++it)
+  {
+    string file_name = it->path().filename().string();
+
+    if (file_name == name + ".sbra"
+        || (it->path().extension() == ".flann"
+            && !file_name.compare(0, name.size() + 1, name + ".")))
+      files.push_back(it->path());
+  }
+
+  for (fs::path a_file : files)
+    fs::remove(a_file);
+}
+
+/**
+ * @brief Reads a whole file.
+ */
+static string readFile(const string& file_name)
+{
+  ifstream file(file_name.c_str(), ios::binary);
+  ostringstream content;
+  content << file.rdbuf();
+
+  return content.str();
+}
+
+/**
+ * @brief Runs the benchmark with the given name.
+ *
+ * @param[in] name    The name of the benchmark.
+ * @param[in] db      The IStuff::Database to be benchmarked.
+ * @param[in] folder  The folder containing the sample images.
+ *
+ * @return The exit code of the program.
+ */
+int runBenchmark(const string& name, Database* db, const string& folder)
+{
+  if (name == "scale")
+    benchmarkScales(db, folder);
+  else if (name == "serialization")
+    benchmarkSerialization(db);
+  else if (name == "startup")
+    benchmarkStartup(db);
+  else if (name == "build")
+    benchmarkBuild(db, folder);
+  else if (name == "queue")
+    benchmarkQueue();
+  else
+  {
+    cerr << "Undefined benchmark.\n";
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Measures speed and accuracy of the recognition at various resolutions.
+ * @details Every image of the folder is recognized at each scale; the error is
+ *  the mean distance between the IStuff::Label found and the ones of the .lbl
+ *  file of the image.
+ *
+ * @param[in] db      The IStuff::Database used for the recognition.
+ * @param[in] folder  The folder containing the labelled images.
+ */
+void benchmarkScales(Database* db, const string& folder)
+{
+  const float scales[] = {1, .75, .5, .35, .25};
+
+  vector<LabelledImage> images = loadImages(folder);
+  if (images.empty())
+  {
+    cerr << "No images found in " << folder << ".\n";
+    return;
+  }
+
+  float original_scale = db->getRecognitionScale();
+
+  cout << "Scale\tTime (ms)\tRecognized\tLabels\tMean error (px)\n";
+
+  for (float a_scale : scales)
+  {
+    db->setRecognitionScale(a_scale);
+
+    double time = 0,
+           error = 0;
+    size_t recognized = 0,
+           labels_found = 0;
+
+    for (LabelledImage an_image : images)
+    {
+      Clock::time_point start = Clock::now();
+      Object found = db->match(an_image.image);
+      time += boost::chrono::duration<double>(Clock::now() - start).count();
+
+      if (found.empty())
+        continue;
+
+      recognized++;
+
+      for (Label a_label : found.getLabels())
+        for (Label expected : an_image.labels)
+          if (a_label == expected)
+          {
+            error += norm(a_label.position - expected.position);
+            labels_found++;
+          }
+    }
+
+    cout << a_scale << "\t"
+      << time * 1000 / images.size() << "\t"
+      << recognized << "/" << images.size() << "\t"
+      << labels_found << "\t";
+
+    if (labels_found > 0)
+      cout << error / labels_found << endl;
+    else
+      cout << "-\n";
+  }
+
+  db->setRecognitionScale(original_scale);
+}
+
+/**
+ * @brief Compares the bulk cv::Mat serialization with the element by element one.
+ * @details The descriptors of the IStuff::Database, whatever its file format,
+ *  are saved and loaded with both serializations, checking whether they produce
+ *  the same stream and that every round trip, also across the two, gives back
+ *  the same matrices; a non continuous ROI and a set of cv::KeyPoint are round
+ *  tripped too.
+ *
+ * @param[in] db  The IStuff::Database whose descriptors are used.
+ */
+void benchmarkSerialization(Database* db)
+{
+  const int REPETITIONS = 5;
+
+  vector<Mat> bulk = db->copyDescriptors();
+
+  if (bulk.empty())
+  {
+    cerr << "No descriptors in the database " << db->getName() << ".\n";
+    return;
+  }
+
+  vector<BytewiseMat> bytewise(bulk.size());
+  for (size_t i = 0; i < bulk.size(); i++)
+    bytewise[i].mat = bulk[i];
+
+  string bulk_data = serialize(bulk),
+         bytewise_data = serialize(bytewise);
+
+  double megabytes = bulk_data.size() / (1024. * 1024.);
+
+  cout << "Matrices\tSize (MB)\n";
+  cout << bulk.size() << "\t" << megabytes << endl << endl;
+
+  // Round trips, across the two serializations too
+  vector<Mat> bulk_loaded;
+  vector<BytewiseMat> bytewise_loaded;
+  deserialize(bytewise_data, bulk_loaded);
+  deserialize(bulk_data, bytewise_loaded);
+
+  bool round_trip = bulk_loaded.size() == bulk.size()
+    && bytewise_loaded.size() == bulk.size();
+  for (size_t i = 0; round_trip && i < bulk.size(); i++)
+    round_trip = sameMat(bulk[i], bulk_loaded[i])
+      && sameMat(bulk[i], bytewise_loaded[i].mat);
+
+  cout << "Same stream\t" << (bulk_data == bytewise_data ? "yes" : "no") << endl;
+  cout << "Round trip\t" << (round_trip ? "ok" : "FAILED") << endl;
+
+  if (!bulk.empty() && bulk[0].cols > 1)
+  {
+    Mat roi = bulk[0].colRange(0, bulk[0].cols / 2),
+        roi_loaded;
+    deserialize(serialize(roi), roi_loaded);
+
+    cout << "ROI round trip\t" << (sameMat(roi, roi_loaded) ? "ok" : "FAILED")
+      << endl;
+  }
+
+  vector<KeyPoint> key_points,
+                   key_points_loaded;
+  for (int i = 0; i < 1000; i++)
+    key_points.push_back(KeyPoint(i * .5, i * .25, i % 32, i % 360, i * .1,
+                                  i % 4, i));
+  deserialize(serialize(key_points), key_points_loaded);
+
+  bool same_key_points = key_points.size() == key_points_loaded.size();
+  for (size_t i = 0; same_key_points && i < key_points.size(); i++)
+    same_key_points = key_points[i].pt == key_points_loaded[i].pt
+      && key_points[i].size == key_points_loaded[i].size
+      && key_points[i].angle == key_points_loaded[i].angle
+      && key_points[i].response == key_points_loaded[i].response
+      && key_points[i].octave == key_points_loaded[i].octave
+      && key_points[i].class_id == key_points_loaded[i].class_id;
+
+  cout << "KeyPoint round trip\t" << (same_key_points ? "ok" : "FAILED")
+    << endl << endl;
+
+  // Throughput
+  double bulk_save = 0,
+         bulk_load = 0,
+         bytewise_save = 0,
+         bytewise_load = 0;
+
+  for (int i = 0; i < REPETITIONS; i++)
+  {
+    Clock::time_point start = Clock::now();
+    serialize(bulk);
+    Clock::time_point saved = Clock::now();
+    deserialize(bulk_data, bulk_loaded);
+    Clock::time_point loaded = Clock::now();
+
+    bulk_save += boost::chrono::duration<double>(saved - start).count();
+    bulk_load += boost::chrono::duration<double>(loaded - saved).count();
+
+    start = Clock::now();
+    serialize(bytewise);
+    saved = Clock::now();
+    deserialize(bytewise_data, bytewise_loaded);
+    loaded = Clock::now();
+
+    bytewise_save += boost::chrono::duration<double>(saved - start).count();
+    bytewise_load += boost::chrono::duration<double>(loaded - saved).count();
+  }
+
+  cout << "Format\tSave (MB/s)\tLoad (MB/s)\n";
+  cout << "Bulk\t" << megabytes * REPETITIONS / bulk_save << "\t"
+    << megabytes * REPETITIONS / bulk_load << endl;
+  cout << "Bytewise\t" << megabytes * REPETITIONS / bytewise_save << "\t"
+    << megabytes * REPETITIONS / bytewise_load << endl;
+}
+
+/**
+ * @brief Compares loading the saved matcher index with retraining it.
+ * @details The whole IStuff::Database loading is timed too, as it is the cold
+ *  start cost of the program.
+ *
+ * @param[in] db  The IStuff::Database to be loaded again.
+ */
+void benchmarkStartup(Database* db)
+{
+  const int REPETITIONS = 5;
+
+  FeatureBackend backend = db->getBackend();
+  const vector<Mat>& descriptors = db->getDescriptors();
+
+  double database_load = 0,
+         index_load = 0,
+         retrain = 0;
+  bool index_loaded = backend.isPersistent();
+
+  for (int i = 0; i < REPETITIONS; i++)
+  {
+    Clock::time_point start = Clock::now();
+    delete new Database(db->getName(), "");
+    database_load += boost::chrono::duration<double>(Clock::now() - start).count();
+
+    if (backend.isPersistent())
+    {
+      Ptr<DescriptorMatcher> loaded = backend.createMatcher();
+
+      start = Clock::now();
+      loaded->add(descriptors);
+      index_loaded = index_loaded
+        && dynamic_cast<PersistentFlannMatcher*>(loaded.obj)->loadIndex(db->getIndexFileName());
+      index_load += boost::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    Ptr<DescriptorMatcher> trained = backend.createMatcher();
+
+    start = Clock::now();
+    trained->add(descriptors);
+    trained->train();
+    retrain += boost::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  size_t descriptor_count = 0;
+  for (Mat some_descriptors : descriptors)
+    descriptor_count += some_descriptors.rows;
+
+  cout << "Backend\tSamples\tDescriptors\n";
+  cout << backend.getFeaturesName() << "/" << backend.getMatcherName() << "\t"
+    << descriptors.size() << "\t" << descriptor_count << endl << endl;
+
+  cout << "Stage\tTime (ms)\n";
+  cout << "Database load\t" << database_load * 1000 / REPETITIONS << endl;
+
+  if (!backend.isPersistent())
+    cout << "Index load\t- (not persistent)\n";
+  else if (!index_loaded)
+    cout << "Index load\tFAILED\n";
+  else
+    cout << "Index load\t" << index_load * 1000 / REPETITIONS << endl;
+
+  cout << "Retrain\t" << retrain * 1000 / REPETITIONS << endl;
+}
+
+/**
+ * @brief Compares the serial creation of a database with the parallel one.
+ * @details Both databases are created from scratch under temporary names,
+ *  with the backend of the given one, and removed at the end.
+ *
+ * @param[in] db      The IStuff::Database whose backend is used.
+ * @param[in] folder  The folder containing the sample images.
+ */
+void benchmarkBuild(Database* db, const string& folder)
+{
+  string serial_name = db->getName() + "_serial",
+         parallel_name = db->getName() + "_parallel";
+
+  removeDatabase(serial_name);
+  removeDatabase(parallel_name);
+
+  Database* serial = new Database(serial_name, folder, db->getBackend(), 1);
+  Database* parallel = new Database(parallel_name, folder, db->getBackend());
+
+  BuildProfile serial_profile = serial->getBuildProfile(),
+               parallel_profile = parallel->getBuildProfile();
+
+  cout << "Serial\n";
+  printBuildProfile(serial_profile);
+  cout << "\nParallel\n";
+  printBuildProfile(parallel_profile);
+
+  cout << "\nSpeedup\t" << serial_profile.extraction / parallel_profile.extraction
+    << endl;
+  cout << "Same file\t"
+    << (readFile("database/" + serial_name + ".sbra")
+        == readFile("database/" + parallel_name + ".sbra") ? "yes" : "NO")
+    << endl;
+
+  delete serial;
+  delete parallel;
+
+  removeDatabase(serial_name);
+  removeDatabase(parallel_name);
+}
+
+/**
+ * @brief Prints the time spent creating a database, stage by stage.
+ *
+ * @param[in] profile  The IStuff::BuildProfile of the database.
+ */
+void printBuildProfile(const BuildProfile& profile)
+{
+  double stages = profile.reading + profile.features + profile.labels;
+
+  cout << "Samples: " << profile.samples << endl;
+  cout << "Threads: " << profile.threads << endl;
+  cout << "\tReading: " << profile.reading * 1000 << " ms\n";
+  cout << "\tDetection and description: " << profile.features * 1000 << " ms\n";
+  cout << "\tLabels: " << profile.labels * 1000 << " ms\n";
+  cout << "\tExtraction (wall): " << profile.extraction * 1000 << " ms"
+    << " (" << stages / profile.extraction << "x)\n";
+  cout << "\tTraining: " << profile.training * 1000 << " ms\n";
+  cout << "\tSaving: " << profile.saving * 1000 << " ms\n";
+}
+
+/**
+ * @brief Stress test of the IStuff::FakableQueue between a capture and a consumer thread.
+ * @details A producer enqueues frames at a fixed rate, as a camera would,
+ *  starting the queue again every RESTART_PERIOD frames as the tracker does at
+ *  every recognition, while a consumer dequeues them as soon as they are
+ *  available. Every frame carries its sequence number and enqueue time, so
+ *  that reordered frames are found and the latency from enqueue to dequeue is
+ *  measured; the histogram counts the frames by latency.
+ */
+void benchmarkQueue()
+{
+  const int RATES[] = {60, 120};
+  const double DURATION = 3;
+  const int RESTART_PERIOD = 30;
+  // Upper bounds of the latency buckets, in microseconds
+  const double BUCKETS[] = {1, 10, 100, 1000, 10000};
+  const size_t BUCKET_COUNT = sizeof(BUCKETS) / sizeof(BUCKETS[0]);
+
+  cout << "Rate\tFrames\tReceived\tOut of order\tDropped\tMax enqueue (us)";
+  for (double a_bucket : BUCKETS)
+    cout << "\t<" << a_bucket << " us";
+  cout << "\t>=" << BUCKETS[BUCKET_COUNT - 1] << " us\n";
+
+  for (int a_rate : RATES)
+  {
+    FakableQueue queue;
+    int frame_count = a_rate * DURATION;
+    vector<size_t> histogram(BUCKET_COUNT + 1, 0);
+    size_t received = 0,
+           out_of_order = 0;
+    double max_enqueue = 0;
+    std::atomic<bool> producing(true);
+
+    Clock::time_point origin = Clock::now();
+
+    boost::thread consumer([&]()
+    {
+      Mat frame;
+      double expected = 0;
+
+      while (producing || queue.size() > 0)
+      {
+        if (!queue.tryDequeue(frame))
+        {
+          boost::this_thread::yield();
+          continue;
+        }
+
+        double latency = boost::chrono::duration<double, boost::micro>(
+            Clock::now() - origin).count() - frame.at<double>(1);
+
+        size_t bucket = 0;
+        while (bucket < BUCKET_COUNT && latency >= BUCKETS[bucket])
+          bucket++;
+        histogram[bucket]++;
+
+        if (frame.at<double>(0) < expected)
+          out_of_order++;
+        expected = frame.at<double>(0) + 1;
+        received++;
+      }
+    });
+
+    for (int i = 0; i < frame_count; i++)
+    {
+      boost::this_thread::sleep_until(
+          origin + boost::chrono::microseconds(1000000LL * i / a_rate));
+
+      Mat frame(1, 2, CV_64F);
+      frame.at<double>(0) = i;
+
+      Clock::time_point before = Clock::now();
+      frame.at<double>(1) = boost::chrono::duration<double, boost::micro>(
+          before - origin).count();
+
+      if (i % RESTART_PERIOD == 0)
+        queue.start(frame);
+      else
+        queue.enqueue(frame);
+
+      max_enqueue = max(max_enqueue,
+                        boost::chrono::duration<double, boost::micro>(
+                          Clock::now() - before).count());
+    }
+
+    producing = false;
+    consumer.join();
+
+    cout << a_rate << "\t" << frame_count << "\t" << received << "\t"
+      << out_of_order << "\t" << queue.getDropped() << "\t" << max_enqueue;
+    for (size_t a_count : histogram)
+      cout << "\t" << a_count;
+    cout << endl;
+  }
+}
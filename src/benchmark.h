@@ -0,0 +1,42 @@
+/**
+ * @file benchmark.h
+ * @brief Header file for the benchmarks runnable from the command line.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef BENCHMARK_H__
+#define BENCHMARK_H__
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/highgui/highgui.hpp"
+
+#include <boost/chrono.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+
+#include "IStuff/database.h"
+#include "IStuff/fakable_queue.h"
+
+extern bool debug,
+            hl_debug;
+
+int runBenchmark(const std::string&, IStuff::Database*, const std::string&);
+
+void benchmarkScales(IStuff::Database*, const std::string&);
+void benchmarkSerialization(IStuff::Database*);
+void benchmarkStartup(IStuff::Database*);
+void benchmarkBuild(IStuff::Database*, const std::string&);
+void benchmarkQueue();
+
+void printBuildProfile(const IStuff::BuildProfile&);
+
+#endif /* defined BENCHMARK_H__ */
@@ -24,11 +24,30 @@ using namespace IStuff;
 int main(int argc, char* argv[])
 {
   bool video = false,
-	   notrack = false;
+	   notrack = false,
+       headless = false,
+       fbCheck = false;
+  float scale = 1;
+  int trees = 4,
+      checks = 32,
+      threads = 0,
+      recognizers = 0,
+      words = 0,
+      candidates = 10,
+      hypotheses = 3,
+      minPeriod = 10,
+      maxPeriod = 120;
   string dbName,
          dbDir,
-         videoSrc,
-         videoDst;
+         videoDst,
+         resultsDst,
+         benchmark,
+         features = "SIFT",
+         matcher,
+         motion = "local";
+  vector<string> samplesToAdd,
+                 samplesToRemove,
+                 videoSrcs;
 
   // Command line flags parsing, mostly debug level
   if (argc == 1)
@@ -58,7 +77,7 @@ int main(int argc, char* argv[])
       else if(!strcmp(argv[i], "video" ))
       {
         video = true;
-        videoSrc = argv[++i];
+        videoSrcs.push_back(argv[++i]);
       }
       else if(!strcmp(argv[i], "database"))
       {
@@ -76,6 +95,82 @@ int main(int argc, char* argv[])
       {
         videoDst = argv[++i];
       }
+      else if (!strcmp(argv[i], "headless"))
+      {
+        headless = true;
+      }
+      else if (!strcmp(argv[i], "motion"))
+      {
+        motion = argv[++i];
+      }
+      else if (!strcmp(argv[i], "fb-check"))
+      {
+        fbCheck = true;
+      }
+      else if (!strcmp(argv[i], "results"))
+      {
+        resultsDst = argv[++i];
+      }
+      else if (!strcmp(argv[i], "scale"))
+      {
+        scale = atof(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "benchmark"))
+      {
+        benchmark = argv[++i];
+      }
+      else if (!strcmp(argv[i], "features"))
+      {
+        features = argv[++i];
+      }
+      else if (!strcmp(argv[i], "matcher"))
+      {
+        matcher = argv[++i];
+      }
+      else if (!strcmp(argv[i], "trees"))
+      {
+        trees = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "checks"))
+      {
+        checks = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "threads"))
+      {
+        threads = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "recognizers"))
+      {
+        recognizers = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "words"))
+      {
+        words = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "candidates"))
+      {
+        candidates = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "hypotheses"))
+      {
+        hypotheses = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "min-period"))
+      {
+        minPeriod = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "max-period"))
+      {
+        maxPeriod = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "add"))
+      {
+        samplesToAdd.push_back(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "remove"))
+      {
+        samplesToRemove.push_back(argv[++i]);
+      }
     }
     else
     {
@@ -116,6 +211,10 @@ int main(int argc, char* argv[])
           extended_command = "--output";
           argv[i--] = &extended_command[0];
           break;
+        case 's':
+          extended_command = "--scale";
+          argv[i--] = &extended_command[0];
+          break;
         default:
           // No other flags yet.
           cerr << "Undefined flag.\n";
@@ -125,6 +224,39 @@ int main(int argc, char* argv[])
     }
   }
 
+  // Without --video the camera is used; a --video made of digits is the
+  // camera with that index
+  if (!video)
+    videoSrcs.push_back("0");
+
+  bool cameras = false;
+  for (string a_source : videoSrcs)
+    cameras |= a_source.find_first_not_of("0123456789") == string::npos;
+
+  // Without a window there's no key to stop a camera with
+  if (headless && cameras)
+  {
+    cerr << "Headless mode needs --video files.\n";
+    printHelp();
+    exit(1);
+  }
+
+  Tracker::MotionModel motionModel;
+  if (motion == "local")
+    motionModel = Tracker::MOTION_LOCAL;
+  else if (motion == "similarity")
+    motionModel = Tracker::MOTION_SIMILARITY;
+  else if (motion == "affine")
+    motionModel = Tracker::MOTION_AFFINE;
+  else if (motion == "homography")
+    motionModel = Tracker::MOTION_HOMOGRAPHY;
+  else
+  {
+    cerr << "Undefined motion model " << motion << ".\n";
+    printHelp();
+    exit(1);
+  }
+
   if (debug)
     cerr << "Flags parsed. Starting.\n";
 
@@ -132,7 +264,14 @@ int main(int argc, char* argv[])
   
   try
   {
-    db = new IStuff::Database(dbName, dbDir);
+    db = new IStuff::Database(dbName, dbDir,
+                              FeatureBackend(features, matcher,
+                                             trees, checks),
+                              threads);
+
+    // Compared with the words asked for, there may be less descriptors
+    if (words > 0 && db->getRequestedVocabularySize() != words)
+      db->trainVocabulary(words);
   }
   catch (IStuff::DBCreationException& e)
   {
@@ -149,122 +288,327 @@ int main(int argc, char* argv[])
     cout << e.what() << endl;
     exit(2);
   }
+  catch (IStuff::DBBackendException& e)
+  {
+    cout << e.what() << endl;
+    exit(2);
+  }
 
-  vector<Mat> output_history;
+  db->setRecognitionScale(scale);
+  db->setCandidates(candidates);
+  db->setHypotheses(hypotheses);
 
-  Manager manager;
-  manager.setDatabase(db);
+  BuildProfile build_profile = db->getBuildProfile();
+  if (build_profile.samples > 0)
+    printBuildProfile(build_profile);
 
-  time_t start = time( NULL );
-  size_t frames = 0;
+  if (!benchmark.empty())
+    return runBenchmark(benchmark, db, dbDir);
 
-  int key = -1;
-  if (!video)
+  // Database update mode: change the samples and exit
+  if (!samplesToAdd.empty() || !samplesToRemove.empty())
   {
-    namedWindow("Camera", CV_WINDOW_AUTOSIZE);
+    int result = 0;
 
-    VideoCapture capture = VideoCapture(CV_CAP_ANY);
-
-    // Show the image captured from the camera in the window and repeat
-    while (key != 'q')
+    try
+    {
+      // Every change at once, training and saving the database only once
+      vector<string> failed;
+      if (!db->updateSamples(samplesToAdd, samplesToRemove, failed))
+        result = 3;
+
+      for (string a_sample : failed)
+        if (find(samplesToRemove.begin(), samplesToRemove.end(), a_sample)
+            != samplesToRemove.end())
+          cerr << "No sample " << a_sample << " in the database.\n";
+        else
+          cerr << "Can't read the sample " << a_sample << ".\n";
+    }
+    catch (IStuff::DBSavingException& e)
     {
-      // Get one frame
-      Mat frame;
-      capture >> frame;
-	  frames++;
+      cout << e.what() << endl;
+      exit(2);
+    }
 
-	  if( notrack )
-	  {
-        Object o = db->match(frame);
-        frame = o.paint(frame);
-	  }
-	  else
-	  {
-        manager.elaborateFrame(frame);
-        frame = manager.paintObject(frame);
-	  }
+    cout << "Samples: " << db->getSampleNames().size() << endl;
 
-      imshow("Camera", frame);
+    return result;
+  }
 
-      if (!videoDst.empty())
-        output_history.push_back(frame);
+  // Frames are kept in recycled buffers, so that in steady state no frame is
+  // allocated.
+  FramePool& frame_pool = FramePool::shared();
 
-      key = waitKey(1);
-    }
+  // Several streams share the database and a pool of recognition threads, one
+  // per stream up to one per core unless --recognizers says otherwise
+  RecognitionPool* pool = NULL;
+  if (videoSrcs.size() > 1)
+  {
+    size_t pool_threads = recognizers;
+    if (pool_threads == 0)
+      pool_threads = min(videoSrcs.size(),
+                         (size_t) max(boost::thread::hardware_concurrency(), 1u));
 
-    capture.release();
-    destroyWindow("Camera");
+    pool = new RecognitionPool(pool_threads);
   }
-  else
+
+  // Capture and processing of each stream run on their own threads, the
+  // render stays here as HighGUI wants. A camera drops the frames the
+  // processing is late for, a video waits for it.
+  // Headless, frames go from the processing straight to the outputs, with no
+  // GUI call: a video is elaborated as fast as the pipeline goes.
+  vector<Stream*> streams;
+  for (size_t s = 0; s < videoSrcs.size(); s++)
   {
-    namedWindow( "Video", CV_WINDOW_AUTOSIZE );
+    Stream* a_stream = new Stream();
+    a_stream->source = videoSrcs[s];
+    a_stream->video = a_stream->source.find_first_not_of("0123456789")
+                        != string::npos;
+    a_stream->window = a_stream->video ? "Video" : "Camera";
+    if (videoSrcs.size() > 1)
+      a_stream->window += " " + a_stream->source;
+
+    if (a_stream->video)
+      a_stream->capture.open(a_stream->source);
+    else
+      a_stream->capture.open(atoi(a_stream->source.c_str()));
+
+    a_stream->fps = a_stream->video ? a_stream->capture.get(CV_CAP_PROP_FPS) : 0;
+
+    a_stream->manager = new Manager();
+    a_stream->manager->setDatabase(db);
+    a_stream->manager->setRecognitionPeriods(minPeriod, maxPeriod);
+    a_stream->manager->setMotionModel(motionModel);
+    a_stream->manager->setForwardBackward(fbCheck);
+    if (pool)
+      a_stream->manager->setRecognitionPool(pool);
+
+    a_stream->pipeline = new Pipeline(db, a_stream->manager, notrack,
+                                      a_stream->video ? Pipeline::NEVER_DROP
+                                                      : Pipeline::LATEST_FRAME);
+    a_stream->pipeline->setPainting(!headless || !videoDst.empty());
+
+    // The output is written while the frames are shown, at the frame rate of
+    // the video if known or at the one measured on the first frames otherwise
+    a_stream->output = NULL;
+    if (!videoDst.empty())
+      a_stream->output = new VideoOutput(streamFileName(videoDst, s,
+                                                        videoSrcs.size()),
+                                         a_stream->fps);
+
+    a_stream->results = NULL;
+    if (!resultsDst.empty())
+    {
+      a_stream->results = new ResultWriter(streamFileName(resultsDst, s,
+                                                          videoSrcs.size()));
+
+      if (!a_stream->results->isOpen())
+        exit(1);
+    }
 
-    VideoCapture capture = VideoCapture( videoSrc );
+    a_stream->frames = 0;
+    a_stream->active = true;
+
+    if (!headless)
+      namedWindow(a_stream->window, CV_WINDOW_AUTOSIZE);
+
+    streams.push_back(a_stream);
+  }
+
+  time_t start = time( NULL );
+
+  for (Stream* a_stream : streams)
+    a_stream->pipeline->start(&a_stream->capture);
+
+  // Show the processed frames in their windows until the sources end or a key
+  // is pressed ('q' if there are cameras)
+  size_t active = streams.size();
+  int key = -1;
+  while (active > 0 && (cameras ? key != 'q' : key == -1))
+  {
+    bool rendered = false;
 
-    // Show the image captured from the camera in the window and repeat
-    while( key == -1 )
+    for (Stream* a_stream : streams)
     {
-      // Get one frame
-      Mat frame;
-      capture >> frame;
-	  frames++;
-
-      if( frame.empty() ) {
-        cerr << "Capture error or video ended. Exiting..\n";
-        break;
+      if (!a_stream->active)
+        continue;
+
+      PipelineFrame frame;
+      if (!a_stream->pipeline->tryNextFrame(frame))
+      {
+        if (a_stream->pipeline->isFinished())
+        {
+          a_stream->active = false;
+          active--;
+        }
+
+        continue;
       }
 
-	  if( notrack )
-	  {
-        Object o = db->match(frame);
-        frame = o.paint(frame);
-	  }
-	  else
-	  {
-        manager.elaborateFrame(frame);
-        frame = manager.paintObject(frame);
-	  }
+      rendered = true;
+      a_stream->frames++;
 
-      imshow( "Video", frame );
+      // A video is timed by its frame rate, a camera by the capture
+      if (a_stream->results)
+        a_stream->results->write(frame.index,
+                                 a_stream->fps > 0 ? frame.index / a_stream->fps
+                                                   : frame.time,
+                                 frame.objects);
 
-      if (!videoDst.empty())
-        output_history.push_back(frame);
+      if (a_stream->output)
+        a_stream->output->write(frame.frame);
+
+      if (!headless)
+      {
+        imshow(a_stream->window, frame.frame);
 
-      key = waitKey( 10 );
+        // The tracker paints off the main thread, it's shown from here
+        if (!frame.debug.empty())
+          imshow(a_stream->window + " tracker", frame.debug);
+      }
     }
 
-    capture.release();
-    destroyWindow( "Video" );
+    if (!headless)
+      key = waitKey(rendered && !cameras ? 10 : 1);
+    else if (!rendered)
+      boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+  }
+
+  for (Stream* a_stream : streams)
+  {
+    a_stream->pipeline->stop();
+    a_stream->capture.release();
+
+    if (!headless)
+      destroyWindow(a_stream->window);
   }
 
   time_t end = time( NULL );
   double duration = difftime( end, start );
-  double fps = (double) frames / duration;
 
-  cout << "Frames: " << frames << endl;
-  cout << "Time: " << duration << endl;
-  cout << "Frame rate: " << fps << endl;
+  for (Stream* a_stream : streams)
+  {
+    if (streams.size() > 1)
+      cout << "Stream " << a_stream->source << ":\n";
+
+    cout << "Frames: " << a_stream->frames << endl;
+    cout << "Time: " << duration << endl;
+    cout << "Frame rate: " << (double) a_stream->frames / duration << endl;
+    cout << "Dropped frames: " << a_stream->pipeline->getDropped() << endl;
+  }
 
-  if (!videoDst.empty())
+  // Per stage cost of Database::match, averaged over its calls
+  MatchProfile profile = db->getProfile();
+  if (profile.calls > 0)
   {
-    float min_fps = 10;
-    int fps_multiplier;
-    if (fps < min_fps)
-      fps_multiplier = ceil(min_fps / fps);
-    
-    VideoWriter output(videoDst,
-                       CV_FOURCC('M', 'J', 'P', 'G'),
-                       fps * fps_multiplier,
-                       output_history[0].size());
-
-    for (Mat frame : output_history)
-      for (size_t i = 0; i < fps_multiplier; i++)
-        output << frame;
+    double to_ms = 1000. / profile.calls;
+
+    cout << "Matches: " << profile.calls << endl;
+    cout << "\tConstruction: " << profile.construction * 1000 << " ms (once)\n";
+    cout << "\tResize: " << profile.resize * to_ms << " ms\n";
+    cout << "\tDetection and description: " << profile.features * to_ms << " ms\n";
+    cout << "\tRetrieval: " << profile.retrieval * to_ms << " ms\n";
+    cout << "\tMatching: " << profile.matching * to_ms << " ms\n";
+    cout << "\tHomography: " << profile.homography * to_ms << " ms\n";
+  }
+
+  // In steady state every buffer acquired is a recycled one
+  FramePoolStats pool_stats = frame_pool.getStats();
+  cout << "Frame buffers: " << pool_stats.acquired << " acquired, "
+    << pool_stats.recycled << " recycled, "
+    << pool_stats.allocated << " allocated, "
+    << pool_stats.pooled << " pooled\n";
+
+  // Why the recognitions were done, over every stream
+  if (!notrack)
+  {
+    SchedulerStats scheduled;
+    for (Stream* a_stream : streams)
+    {
+      SchedulerStats stream_stats = a_stream->manager->getSchedulerStats();
+
+      scheduled.tracked += stream_stats.tracked;
+      scheduled.recognitions += stream_stats.recognitions;
+      scheduled.forced += stream_stats.forced;
+      scheduled.periodic += stream_stats.periodic;
+      scheduled.lost_features += stream_stats.lost_features;
+      scheduled.high_error += stream_stats.high_error;
+      scheduled.spread += stream_stats.spread;
+      scheduled.deferred += stream_stats.deferred;
+    }
+
+    cout << "Recognitions: " << scheduled.recognitions << endl;
+    cout << "\tNo object or forced: " << scheduled.forced << endl;
+    cout << "\tMaximum period: " << scheduled.periodic << endl;
+    cout << "\tFeatures lost: " << scheduled.lost_features << endl;
+    cout << "\tOptical flow error: " << scheduled.high_error << endl;
+    cout << "\tLabel spread: " << scheduled.spread << endl;
+    cout << "Frames tracked: " << scheduled.tracked << ", "
+      << scheduled.deferred << " deferring a recognition\n";
+  }
+
+  for (Stream* a_stream : streams)
+  {
+    if (a_stream->output)
+    {
+      a_stream->output->close();
+
+      cout << "Output: " << a_stream->output->getWritten() << " frames at "
+        << a_stream->output->getFps() << " fps\n";
+
+      delete a_stream->output;
+    }
+
+    if (a_stream->results)
+    {
+      a_stream->results->close();
+
+      cout << "Results: " << a_stream->results->getWritten() << " frames\n";
+
+      delete a_stream->results;
+    }
+
+    // The manager waits for its last recognition, which may be in the pool
+    delete a_stream->pipeline;
+    delete a_stream->manager;
+    delete a_stream;
+  }
+
+  if (pool)
+  {
+    cout << "Recognition threads: " << pool->getThreads() << endl;
+
+    delete pool;
   }
 
   return 0;
 }
 
+/**
+ * @brief Gives each stream its own output file, when there are several.
+ *
+ * @param[in] file_name  The file name given on the command line.
+ * @param[in] stream     The position of the stream.
+ * @param[in] count      The number of streams.
+ *
+ * @return `file_name`, with `_stream` before its extension if `count` > 1.
+ */
+string streamFileName(const string& file_name, size_t stream, size_t count)
+{
+  if (count <= 1)
+    return file_name;
+
+  size_t dot = file_name.find_last_of('.'),
+         slash = file_name.find_last_of('/');
+  if (dot == string::npos || (slash != string::npos && dot < slash))
+    dot = file_name.size();
+
+  ostringstream numbered;
+  numbered << file_name.substr(0, dot) << "_" << stream << file_name.substr(dot);
+
+  return numbered.str();
+}
+
 /**
  * @brief Function to display the help message.
  */
@@ -279,7 +623,64 @@ void printHelp()
   cout << "\t--database name\tLoad the database called `name`. (necessary)\n";
   cout << "\t--folder path\tIndicates where to find images\n"
     << "\t\t\tfor database creation. (Also -f)\n";
-  cout << "\t--video path\tUse video instead of camera. (Also -v)\n";
-  cout << "\t--output path\tOutput result to video. (Also -o)\n";
+  cout << "\t--features name\tFeatures used for database creation:\n"
+    << "\t\t\tSIFT (default), SURF, ORB or BRISK.\n";
+  cout << "\t--matcher name\tMatcher used for database creation:\n"
+    << "\t\t\tKDTree (default for SIFT and SURF),\n"
+    << "\t\t\tLSH (default for ORB and BRISK) or BruteForce.\n";
+  cout << "\t--trees N\tTrees of the KDTree matcher of a new database.\n";
+  cout << "\t--checks N\tChecks per search of the KDTree and LSH\n"
+    << "\t\t\tmatchers of a new database.\n";
+  cout << "\t--threads N\tThreads used to create a new database,\n"
+    << "\t\t\tone per core by default.\n";
+  cout << "\t--words N\tTrain a vocabulary of N visual words, used\n"
+    << "\t\t\tto match only the samples similar to a frame.\n";
+  cout << "\t--candidates N\tSamples matched against a frame when the\n"
+    << "\t\t\tdatabase has a vocabulary, 10 by default,\n"
+    << "\t\t\t0 for all of them.\n";
+  cout << "\t--hypotheses N\tBest voted samples verified for each frame,\n"
+    << "\t\t\tin parallel, 3 by default.\n";
+  cout << "\t--min-period N\tFrames tracked at least between two\n"
+    << "\t\t\trecognitions, 10 by default.\n";
+  cout << "\t--max-period N\tFrames tracked at most between two\n"
+    << "\t\t\trecognitions, 120 by default. In between, a\n"
+    << "\t\t\trecognition is done when the tracking degrades.\n";
+  cout << "\t--motion name\tHow the labels follow the tracked features:\n"
+    << "\t\t\tlocal (default, mean of the nearest ones),\n"
+    << "\t\t\tsimilarity, affine or homography, fitted to\n"
+    << "\t\t\tall of them rejecting the outliers.\n";
+  cout << "\t--fb-check\tDrop the features not tracked back to\n"
+    << "\t\t\twhere they were.\n";
+  cout << "\t--add path\tAdd the image `path`, with its .lbl file,\n"
+    << "\t\t\tto the database and exit. Repeatable.\n";
+  cout << "\t--remove name\tRemove the sample `name`, the stem of its\n"
+    << "\t\t\timage, from the database and exit. Repeatable.\n";
+  cout << "\t--video path\tUse video instead of camera. (Also -v)\n"
+    << "\t\t\tRepeatable, to elaborate several streams at once;\n"
+    << "\t\t\ta number is the camera with that index.\n";
+  cout << "\t--recognizers N\tRecognition threads shared by several\n"
+    << "\t\t\tstreams, one per stream up to one per core\n"
+    << "\t\t\tby default.\n";
+  cout << "\t--output path\tOutput result to video. (Also -o)\n"
+    << "\t\t\tWith several streams, `path` gets `_N` before\n"
+    << "\t\t\tthe extension, N being the stream. The same\n"
+    << "\t\t\tgoes for --results.\n";
+  cout << "\t--results path\tWrite the labels found in every frame,\n"
+    << "\t\t\twith their positions, to a .csv or .json file.\n";
+  cout << "\t--headless\tProcess the --video files as fast as possible,\n"
+    << "\t\t\twithout showing it.\n";
+  cout << "\t--scale factor\tDownscale frames by `factor` before\n"
+    << "\t\t\trecognizing them. (Also -s)\n";
+  cout << "\t--benchmark name\tRun the benchmark called `name` and exit.\n"
+    << "\t\t\tscale: recognition speed and accuracy of the\n"
+    << "\t\t\timages in --folder at various resolutions.\n"
+    << "\t\t\tserialization: bulk against element by element\n"
+    << "\t\t\tdescriptors serialization.\n"
+    << "\t\t\tstartup: database loading, with the saved index\n"
+    << "\t\t\tagainst retraining it.\n"
+    << "\t\t\tbuild: serial against parallel creation of a\n"
+    << "\t\t\tdatabase from --folder.\n"
+    << "\t\t\tqueue: stress test and latency of the frame\n"
+    << "\t\t\tqueue of the tracker at 60 and 120 fps.\n";
 }
 
@@ -10,17 +10,51 @@
 #define MAIN_H__
 
 #include <iostream>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <cctype>
+#include <algorithm>
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/highgui/highgui.hpp"
 
 #include "IStuff/manager.h"
+#include "IStuff/recognition_pool.h"
+
+#include "benchmark.h"
+#include "pipeline.h"
+#include "video_output.h"
+#include "result_writer.h"
 
 bool debug,
      hl_debug;
 
+/**
+ * @brief A source of frames, elaborated by its own IStuff::Manager.
+ */
+struct Stream
+{
+  std::string source,
+              window;
+  // A video file, as opposed to a camera
+  bool video;
+  double fps;
+
+  cv::VideoCapture capture;
+  IStuff::Manager* manager;
+  Pipeline* pipeline;
+  VideoOutput* output;
+  ResultWriter* results;
+
+  size_t frames;
+  bool active;
+};
+
 int main(int, char**);
 
+std::string streamFileName(const std::string&, size_t, size_t);
+
 void printHelp();
 
 #endif /* defined MAIN_H__ */
@@ -0,0 +1,241 @@
+/**
+ * @file pipeline.cpp
+ * @brief Capture, processing and render of the frames as a pipeline.
+ * @details Capture and processing run each on its own thread, linked to each
+ *  other and to the render by IStuff::BoundedQueue, so that the frame rate is
+ *  the one of the slowest stage instead of the sum of the stages.
+ *  The render stays on the thread calling nextFrame(), which must be the main
+ *  one, as HighGUI wants.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#include "pipeline.h"
+
+using namespace std;
+using namespace cv;
+using namespace IStuff;
+
+const char Pipeline::TAG[] = "Ppl";
+
+/* Constructors and Destructors */
+
+/**
+ * @brief Constructs a pipeline, not started yet.
+ *
+ * @param[in] database  The IStuff::Database used when not tracking.
+ * @param[in] manager   The IStuff::Manager elaborating the frames.
+ * @param[in] notrack   Whether to use just pure recognition.
+ * @param[in] policy    What to do with the frames a stage is late for.
+ */
+Pipeline::Pipeline(Database* database, Manager* manager, bool notrack,
+                   DropPolicy policy)
+  : m_database(database), m_manager(manager), m_notrack(notrack),
+    m_policy(policy), m_painting(true), m_capture(NULL),
+    m_captured(policy == LATEST_FRAME ? LATEST_FRAME_CAPACITY : NEVER_DROP_CAPACITY),
+    m_processed(policy == LATEST_FRAME ? LATEST_FRAME_CAPACITY : NEVER_DROP_CAPACITY),
+    m_stopping(false)
+{
+  // The frames in both queues, plus the one captured, the one processed with
+  // its painted copy, and the one shown
+  FramePool::shared().reserve(m_captured.capacity() + m_processed.capacity() + 4);
+}
+
+Pipeline::~Pipeline()
+{
+  stop();
+}
+
+/* Setters */
+
+/**
+ * @brief Chooses whether the IStuff::Object found are painted on the frames.
+ * @details Must be called before starting the pipeline.
+ *
+ * @param[in] painting  `false` to leave the frames of the pipeline empty.
+ */
+void Pipeline::setPainting(bool painting)
+{
+  m_painting = painting;
+}
+
+/* Getters */
+
+/**
+ * @brief Returns how many frames were dropped because a stage was late.
+ */
+size_t Pipeline::getDropped() const
+{
+  return m_captured.getDropped() + m_processed.getDropped();
+}
+
+/**
+ * @brief Checks whether the source is over and every frame has been rendered.
+ */
+bool Pipeline::isFinished() const
+{
+  // Once closed nothing is added, so the queue being empty is final
+  return m_processed.isClosed() && m_processed.size() == 0;
+}
+
+/* Other methods */
+
+/**
+ * @brief Starts the capture and processing threads.
+ *
+ * @param[in] capture  The source of the frames, used only by the capture thread
+ *  until the pipeline is stopped.
+ */
+void Pipeline::start(VideoCapture* capture)
+{
+  m_capture = capture;
+
+  m_capture_thread = boost::thread(&Pipeline::captureLoop, this);
+  m_process_thread = boost::thread(&Pipeline::processLoop, this);
+}
+
+/**
+ * @brief Waits for the next processed frame, to be rendered.
+ *
+ * @param[out] frame  The frame with the IStuff::Object found, painted on it.
+ *
+ * @return `false` once the source is over and every frame has been rendered.
+ */
+bool Pipeline::nextFrame(PipelineFrame& frame)
+{
+  return m_processed.pop(frame);
+}
+
+/**
+ * @brief Takes the next processed frame, if there's one, without waiting.
+ * @details Used to render several pipelines from the same thread.
+ *
+ * @param[out] frame  The frame with the IStuff::Object found, painted on it.
+ *
+ * @return `false` if no frame is ready; see isFinished() to tell whether
+ *  more will come.
+ */
+bool Pipeline::tryNextFrame(PipelineFrame& frame)
+{
+  return m_processed.tryPop(frame);
+}
+
+/**
+ * @brief Stops the pipeline, waiting for its threads.
+ */
+void Pipeline::stop()
+{
+  m_stopping = true;
+  m_captured.close();
+  m_processed.close();
+
+  if (m_capture_thread.joinable())
+    m_capture_thread.join();
+  if (m_process_thread.joinable())
+    m_process_thread.join();
+}
+
+/**
+ * @brief Hands a frame to the next stage, according to the drop policy.
+ *
+ * @return `false` if the pipeline is stopping.
+ */
+bool Pipeline::forward(BoundedQueue<PipelineFrame>& queue,
+                       const PipelineFrame& frame)
+{
+  if (m_policy == LATEST_FRAME)
+    return queue.pushLatest(frame);
+  else
+    return queue.push(frame);
+}
+
+/**
+ * @brief Body of the capture thread.
+ * @details Every frame is read straight into a buffer of the IStuff::FramePool,
+ *  with the geometry of the previous frame, which stays valid as long as it's
+ *  referenced. Only the first frame, or one changing geometry, is allocated.
+ */
+void Pipeline::captureLoop()
+{
+  typedef boost::chrono::high_resolution_clock Clock;
+
+  FramePool& frame_pool = FramePool::shared();
+  Size size;
+  int type = 0;
+  Clock::time_point start = Clock::now();
+
+  for (size_t index = 0; !m_stopping; index++)
+  {
+    PipelineFrame a_frame;
+
+    // Retrieving copies into the buffer as it is, if it has the right geometry
+    a_frame.frame = frame_pool.acquire(size, type);
+    *m_capture >> a_frame.frame;
+
+    if (a_frame.frame.empty())
+    {
+      cerr << "Capture error or video ended. Exiting..\n";
+      break;
+    }
+
+    size = a_frame.frame.size();
+    type = a_frame.frame.type();
+
+    a_frame.index = index;
+    a_frame.time = boost::chrono::duration<double>(Clock::now() - start).count();
+
+    if (!forward(m_captured, a_frame))
+      break;
+  }
+
+  m_captured.close();
+
+  if (debug)
+    cerr << TAG << ": Capture ended.\n";
+}
+
+/**
+ * @brief Body of the processing thread.
+ * @details Every frame is elaborated and then, if painting, painted in a
+ *  buffer of the IStuff::FramePool.
+ */
+void Pipeline::processLoop()
+{
+  FramePool& frame_pool = FramePool::shared();
+  PipelineFrame a_frame;
+
+  while (m_captured.pop(a_frame))
+  {
+    if (m_notrack)
+      a_frame.objects = m_database->matchAll(a_frame.frame);
+    else
+    {
+      m_manager->elaborateFrame(a_frame.frame);
+      a_frame.objects.assign(1, m_manager->getObject());
+
+      if (debug)
+        a_frame.debug = m_manager->getDebugImage();
+    }
+
+    if (m_painting)
+    {
+      Mat painted = frame_pool.acquire(a_frame.frame.size(), a_frame.frame.type());
+
+      a_frame.frame.copyTo(painted);
+      for (Object an_object : a_frame.objects)
+        an_object.paint(painted, painted);
+
+      a_frame.frame = painted;
+    }
+    else
+      a_frame.frame.release();
+
+    if (!forward(m_processed, a_frame))
+      break;
+  }
+
+  m_processed.close();
+
+  if (debug)
+    cerr << TAG << ": Processing ended.\n";
+}
@@ -0,0 +1,108 @@
+/**
+ * @file pipeline.h
+ * @brief Header file for the capture, processing and render pipeline.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef PIPELINE_H__
+#define PIPELINE_H__
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/highgui/highgui.hpp"
+
+#include <boost/thread.hpp>
+#include <boost/chrono.hpp>
+
+#include "IStuff/manager.h"
+#include "IStuff/bounded_queue.h"
+#include "IStuff/frame_pool.h"
+
+extern bool debug,
+            hl_debug;
+
+/**
+ * @brief A frame going through the pipeline.
+ */
+struct PipelineFrame
+{
+  // Position in the source, from 0
+  size_t index;
+  // Seconds from the start of the pipeline to the capture
+  double time;
+  // The captured frame, then the painted one; empty if not painting
+  cv::Mat frame;
+  std::vector<IStuff::Object> objects;
+  // What the tracker painted, to be shown by the main thread; only with debug
+  cv::Mat debug;
+
+  PipelineFrame()
+    : index(0), time(0)
+  {}
+};
+
+class Pipeline
+{
+  /* Attributes */
+  public:
+    /**
+     * @brief What a stage does when the next one is late.
+     */
+    enum DropPolicy
+    {
+      // The oldest frame waiting is dropped: for live cameras
+      LATEST_FRAME,
+      // The stage waits: for offline videos, where every frame counts
+      NEVER_DROP
+    };
+
+  private:
+    const static char TAG[];
+    const static size_t LATEST_FRAME_CAPACITY = 1;
+    const static size_t NEVER_DROP_CAPACITY = 8;
+
+    IStuff::Database* m_database;
+    IStuff::Manager* m_manager;
+    bool m_notrack;
+    DropPolicy m_policy;
+    bool m_painting;
+
+    cv::VideoCapture* m_capture;
+
+    IStuff::BoundedQueue<PipelineFrame> m_captured,
+                                        m_processed;
+    std::atomic<bool> m_stopping;
+
+    boost::thread m_capture_thread,
+                  m_process_thread;
+
+    /* Methods */
+  public:
+    /* Constructors and Destructors */
+    Pipeline(IStuff::Database*, IStuff::Manager*, bool, DropPolicy);
+    virtual ~Pipeline();
+
+    /* Setters */
+    void setPainting(bool);
+
+    /* Getters */
+    size_t getDropped() const;
+    bool isFinished() const;
+
+    /* Other methods */
+    void start(cv::VideoCapture*);
+    bool nextFrame(PipelineFrame&);
+    bool tryNextFrame(PipelineFrame&);
+    void stop();
+
+  private:
+    bool forward(IStuff::BoundedQueue<PipelineFrame>&, const PipelineFrame&);
+    void captureLoop();
+    void processLoop();
+};
+
+#endif /* defined PIPELINE_H__ */
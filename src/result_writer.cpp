@@ -0,0 +1,229 @@
+/**
+ * @file result_writer.cpp
+ * @brief File of the labels found in every frame.
+ * @details The format is chosen by the extension of the file: `.json` writes
+ *  an array with an element per frame, anything else CSV with a row per
+ *  label.<br />
+ *  Rows are written as the frames arrive, so that a partial file of an
+ *  interrupted run is still readable (but for the closing bracket of JSON).
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#include "result_writer.h"
+
+using namespace std;
+using namespace cv;
+using namespace IStuff;
+
+const char ResultWriter::TAG[] = "Res";
+
+/* Constructors and Destructors */
+
+/**
+ * @brief Opens the file and writes its header.
+ *
+ * @param[in] file_name  The file to be written, `.json` for JSON.
+ */
+ResultWriter::ResultWriter(const string& file_name)
+  : m_file(file_name.c_str()), m_format(CSV), m_written(0)
+{
+  string extension = ".json";
+  if (file_name.size() >= extension.size() &&
+      file_name.compare(file_name.size() - extension.size(),
+                        extension.size(), extension) == 0)
+    m_format = JSON;
+
+  if (!m_file)
+  {
+    cerr << TAG << ": can't open " << file_name << ".\n";
+    return;
+  }
+
+  // Milliseconds for times, well below the pixel for positions
+  m_file.precision(3);
+  m_file << fixed;
+
+  if (m_format == JSON)
+    m_file << "[";
+  else
+    m_file << "frame,time,object,label,x,y\n";
+}
+
+/**
+ * @brief Closes the file.
+ */
+ResultWriter::~ResultWriter()
+{
+  close();
+}
+
+/* Getters */
+
+/**
+ * @brief Checks whether the file could be opened and is still open.
+ */
+bool ResultWriter::isOpen() const
+{
+  return m_file.is_open();
+}
+
+/**
+ * @brief Returns the format of the file.
+ */
+ResultWriter::Format ResultWriter::getFormat() const
+{
+  return m_format;
+}
+
+/**
+ * @brief Returns how many frames have been written.
+ */
+size_t ResultWriter::getWritten() const
+{
+  return m_written;
+}
+
+/* Other methods */
+
+/**
+ * @brief Writes the labels found in a frame.
+ * @details In CSV a frame without labels has no rows, in JSON it has an
+ *  element with no objects.
+ *
+ * @param[in] frame    The position of the frame in the source.
+ * @param[in] time     The time of the frame, in seconds.
+ * @param[in] objects  The IStuff::Object found in the frame.
+ */
+void ResultWriter::write(size_t frame, double time,
+                         const vector<Object>& objects)
+{
+  if (!isOpen())
+    return;
+
+  if (debug)
+    cerr << TAG << ": write frame " << frame << ".\n";
+
+  if (m_format == JSON)
+  {
+    m_file << (m_written > 0 ? ",\n" : "\n")
+      << "  {\"frame\": " << frame << ", \"time\": " << time
+      << ", \"objects\": [";
+
+    bool first_object = true;
+    for (const Object& an_object : objects)
+    {
+      if (an_object.empty())
+        continue;
+
+      m_file << (first_object ? "" : ", ") << "[";
+      first_object = false;
+
+      bool first_label = true;
+      for (const Label& a_label : an_object.getLabels())
+      {
+        m_file << (first_label ? "" : ", ")
+          << "{\"label\": " << quoteJson(a_label.name)
+          << ", \"x\": " << a_label.position.x
+          << ", \"y\": " << a_label.position.y << "}";
+        first_label = false;
+      }
+
+      m_file << "]";
+    }
+
+    m_file << "]}";
+  }
+  else
+  {
+    size_t object_index = 0;
+    for (const Object& an_object : objects)
+    {
+      if (an_object.empty())
+        continue;
+
+      for (const Label& a_label : an_object.getLabels())
+        m_file << frame << "," << time << "," << object_index << ","
+          << quoteCsv(a_label.name) << ","
+          << a_label.position.x << "," << a_label.position.y << "\n";
+
+      object_index++;
+    }
+  }
+
+  m_written++;
+}
+
+/**
+ * @brief Ends the file and closes it; nothing is written afterwards.
+ */
+void ResultWriter::close()
+{
+  if (!isOpen())
+    return;
+
+  if (m_format == JSON)
+    m_file << (m_written > 0 ? "\n]\n" : "]\n");
+
+  m_file.close();
+}
+
+/**
+ * @brief Quotes a CSV field, if it contains separators or quotes.
+ */
+string ResultWriter::quoteCsv(const string& field)
+{
+  if (field.find_first_of(",\"\n\r") == string::npos)
+    return field;
+
+  string quoted = "\"";
+  for (char c : field)
+  {
+    if (c == '"')
+      quoted += '"';
+    quoted += c;
+  }
+
+  return quoted + "\"";
+}
+
+/**
+ * @brief Makes a JSON string out of some text.
+ */
+string ResultWriter::quoteJson(const string& text)
+{
+  ostringstream quoted;
+  quoted << "\"";
+
+  for (char c : text)
+    switch (c)
+    {
+      case '"':
+        quoted << "\\\"";
+        break;
+      case '\\':
+        quoted << "\\\\";
+        break;
+      case '\n':
+        quoted << "\\n";
+        break;
+      case '\r':
+        quoted << "\\r";
+        break;
+      case '\t':
+        quoted << "\\t";
+        break;
+      default:
+        if ((unsigned char) c < 0x20)
+        {
+          const char digits[] = "0123456789abcdef";
+          quoted << "\\u00" << digits[(c >> 4) & 0xf] << digits[c & 0xf];
+        }
+        else
+          quoted << c;
+    }
+
+  quoted << "\"";
+
+  return quoted.str();
+}
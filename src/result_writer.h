@@ -0,0 +1,58 @@
+/**
+ * @file result_writer.h
+ * @brief Header file for the per-frame results file.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef RESULT_WRITER_H__
+#define RESULT_WRITER_H__
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "IStuff/object.h"
+
+extern bool debug;
+
+class ResultWriter
+{
+  /* Attributes */
+  public:
+    enum Format
+    {
+      CSV,
+      JSON
+    };
+
+  private:
+    const static char TAG[];
+
+    std::ofstream m_file;
+    Format m_format;
+    size_t m_written;
+
+    /* Methods */
+  public:
+    /* Constructors and Destructors */
+    ResultWriter(const std::string&);
+    virtual ~ResultWriter();
+
+    /* Getters */
+    bool isOpen() const;
+    Format getFormat() const;
+    size_t getWritten() const;
+
+    /* Other methods */
+    void write(size_t, double, const std::vector<IStuff::Object>&);
+    void close();
+
+  private:
+    static std::string quoteCsv(const std::string&);
+    static std::string quoteJson(const std::string&);
+};
+
+#endif /* defined RESULT_WRITER_H__ */
@@ -0,0 +1,162 @@
+/**
+ * @file video_output.cpp
+ * @brief Video file written while the frames are produced.
+ * @details Frames are handed to an encoder thread through a bounded queue:
+ *  the memory used doesn't depend on the length of the video, and a producer
+ *  faster than the encoder waits for it instead of growing the queue.<br />
+ *  When the frame rate isn't known up front, as for cameras, it's estimated
+ *  from the times the first frames are received, then the file is opened.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#include "video_output.h"
+
+using namespace std;
+using namespace cv;
+using namespace IStuff;
+
+const char VideoOutput::TAG[] = "Vout";
+
+/* Constructors and Destructors */
+
+/**
+ * @brief Starts the encoder thread.
+ *
+ * @param[in] file_name  The video file to be written.
+ * @param[in] fps        The frame rate of the video, 0 (or less) to estimate it.
+ */
+VideoOutput::VideoOutput(const string& file_name, double fps)
+  : m_file_name(file_name), m_fps(fps), m_open_tried(false), m_written(0),
+    m_frames(QUEUE_CAPACITY)
+{
+  // The frames queued, the ones kept to estimate the frame rate and the
+  // one being written
+  FramePool::shared().reserve(QUEUE_CAPACITY + FPS_ESTIMATE_FRAMES + 1);
+
+  // Started last, when everything it uses is constructed
+  m_thread = boost::thread(&VideoOutput::encodeLoop, this);
+}
+
+/**
+ * @brief Writes the frames left and closes the file.
+ */
+VideoOutput::~VideoOutput()
+{
+  close();
+}
+
+/* Getters */
+
+/**
+ * @brief Returns the frame rate of the video, 0 until it's known.
+ */
+double VideoOutput::getFps() const
+{
+  return m_fps;
+}
+
+/**
+ * @brief Returns how many frames have been written.
+ */
+size_t VideoOutput::getWritten() const
+{
+  return m_written;
+}
+
+/* Other methods */
+
+/**
+ * @brief Hands a frame to the encoder.
+ * @details The frame isn't copied: it must not be modified afterwards.
+ *  Waits only if the encoder is QUEUE_CAPACITY frames late.
+ *
+ * @param[in] frame  The frame to be written.
+ *
+ * @return `false` if the output is closed.
+ */
+bool VideoOutput::write(const Mat& frame)
+{
+  TimedFrame a_frame;
+  a_frame.frame = frame;
+  a_frame.time = Clock::now();
+
+  return m_frames.push(a_frame);
+}
+
+/**
+ * @brief Waits for every frame to be written, then closes the file.
+ */
+void VideoOutput::close()
+{
+  m_frames.close();
+
+  if (m_thread.joinable())
+    m_thread.join();
+}
+
+/**
+ * @brief Opens the file and writes the frames received so far.
+ * @details The frame rate, if unknown, is the one of the frames received.
+ */
+void VideoOutput::open()
+{
+  m_open_tried = true;
+
+  if (m_fps <= 0)
+  {
+    double span = boost::chrono::duration<double>(
+        m_pending.back().time - m_pending.front().time).count();
+
+    m_fps = m_pending.size() > 1 && span > 0 ? (m_pending.size() - 1) / span : 1;
+  }
+
+  m_writer.open(m_file_name, CV_FOURCC('M', 'J', 'P', 'G'), m_fps,
+                m_pending.front().frame.size());
+
+  if (!m_writer.isOpened())
+    cerr << "Can't write the video " << m_file_name << ".\n";
+  else if (debug)
+    cerr << TAG << ": Writing " << m_file_name << " at " << m_fps << " fps.\n";
+
+  for (TimedFrame a_frame : m_pending)
+    if (m_writer.isOpened())
+    {
+      m_writer << a_frame.frame;
+      m_written++;
+    }
+
+  m_pending.clear();
+}
+
+/**
+ * @brief Body of the encoder thread.
+ */
+void VideoOutput::encodeLoop()
+{
+  TimedFrame a_frame;
+
+  while (m_frames.pop(a_frame))
+  {
+    if (!m_open_tried)
+    {
+      m_pending.push_back(a_frame);
+
+      if (m_fps > 0 || m_pending.size() >= FPS_ESTIMATE_FRAMES)
+        open();
+    }
+    else if (m_writer.isOpened())
+    {
+      m_writer << a_frame.frame;
+      m_written++;
+    }
+
+    a_frame = TimedFrame();
+  }
+
+  // The frames ended before the frame rate could be estimated
+  if (!m_open_tried && !m_pending.empty())
+    open();
+
+  m_writer.release();
+}
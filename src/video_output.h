@@ -0,0 +1,77 @@
+/**
+ * @file video_output.h
+ * @brief Header file for the streaming video output.
+ * @version 0.1.0
+ * @date 2026-10-16
+ */
+
+#ifndef VIDEO_OUTPUT_H__
+#define VIDEO_OUTPUT_H__
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/highgui/highgui.hpp"
+
+#include <boost/thread.hpp>
+#include <boost/chrono.hpp>
+
+#include "IStuff/bounded_queue.h"
+#include "IStuff/frame_pool.h"
+
+extern bool debug;
+
+class VideoOutput
+{
+  /* Attributes */
+  private:
+    typedef boost::chrono::high_resolution_clock Clock;
+
+    /**
+     * @brief A frame to be written, with the time it was received.
+     */
+    struct TimedFrame
+    {
+      cv::Mat frame;
+      Clock::time_point time;
+    };
+
+    const static char TAG[];
+    const static size_t QUEUE_CAPACITY = 32;
+    // Frames used to estimate the frame rate, when it isn't known
+    const static size_t FPS_ESTIMATE_FRAMES = 30;
+
+    std::string m_file_name;
+    double m_fps;
+
+    cv::VideoWriter m_writer;
+    bool m_open_tried;
+    size_t m_written;
+
+    IStuff::BoundedQueue<TimedFrame> m_frames;
+    std::vector<TimedFrame> m_pending;
+
+    boost::thread m_thread;
+
+    /* Methods */
+  public:
+    /* Constructors and Destructors */
+    VideoOutput(const std::string&, double = 0);
+    virtual ~VideoOutput();
+
+    /* Getters */
+    double getFps() const;
+    size_t getWritten() const;
+
+    /* Other methods */
+    bool write(const cv::Mat&);
+    void close();
+
+  private:
+    void open();
+    void encodeLoop();
+};
+
+#endif /* defined VIDEO_OUTPUT_H__ */